@@ -0,0 +1,156 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AdaptiveTmpFileWriter.h"
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    // Gets an upper bound on the q quantile of the sizes in a histogram of
+    // bit widths.
+    uint64_t Quantile(const std::array<uint32_t, 65>& histogram, uint32_t count, double q)
+    {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * count));
+        uint64_t seen = 0;
+        for (size_t width = 0; width < histogram.size(); ++width)
+        {
+            seen += histogram[width];
+            if (seen >= rank)
+            {
+                return width == 0 ? 0 : (uint64_t{ 1 } << (width - 1)) * 2 - 1;
+            }
+        }
+
+        return UINT64_MAX;
+    }
+}
+
+AdaptiveTmpFileWriter::AdaptiveTmpFileWriter(FILE* file)
+    : m_file(file)
+    , m_buffer(c_minBufferSize)
+{
+    THROW_HR_IF(ErrnoToHresult(errno), setvbuf(m_file, nullptr, _IONBF, 0) != 0);
+}
+
+AdaptiveTmpFileWriter::~AdaptiveTmpFileWriter()
+{
+    try
+    {
+        Flush();
+    }
+    CATCH_LOG()
+}
+
+void AdaptiveTmpFileWriter::Write(std::span<const std::byte> data)
+{
+    ++m_writeSizes[std::bit_width(data.size())];
+    if (++m_writes == c_adaptInterval)
+    {
+        Adapt();
+    }
+
+    if (data.size() >= m_directWriteThreshold)
+    {
+        // Copying this into the buffer would save at most one write, so
+        // write it directly instead, after anything before it.
+        Flush();
+        THROW_HR_IF(ErrnoToHresult(errno), fwrite(data.data(), 1, data.size(), m_file) != data.size());
+        return;
+    }
+
+    if (m_used + data.size() > m_buffer.size())
+    {
+        ++m_fullFlushes;
+        Flush();
+    }
+
+    std::memcpy(m_buffer.data() + m_used, data.data(), data.size());
+    m_used += data.size();
+    m_highWater = std::max(m_highWater, m_used);
+    ++m_bufferedWrites;
+}
+
+void AdaptiveTmpFileWriter::Flush()
+{
+    if (m_used == 0)
+    {
+        return;
+    }
+
+    THROW_HR_IF(ErrnoToHresult(errno), fwrite(m_buffer.data(), 1, m_used, m_file) != m_used);
+    m_used = 0;
+}
+
+void AdaptiveTmpFileWriter::Adapt()
+{
+    size_t bufferSize = m_buffer.size();
+    if (Quantile(m_writeSizes, m_writes, 0.5) >= c_directWriteSize)
+    {
+        // Mostly bulk writes. Keep a small buffer for the odd small write
+        // and pass everything else through.
+        bufferSize = c_minBufferSize;
+    }
+    else if (m_fullFlushes > 0 && m_bufferedWrites / m_fullFlushes < c_writesPerSyscall)
+    {
+        // Small writes are filling the buffer too quickly; batch more of
+        // them per syscall.
+        bufferSize = std::min(bufferSize * 2, c_maxBufferSize);
+    }
+    else if (m_highWater < bufferSize / 4)
+    {
+        bufferSize = std::max(bufferSize / 2, c_minBufferSize);
+    }
+
+    // Writes far bigger than usual aren't worth copying. Nor is anything
+    // that would take up half the buffer, since buffering it would save at
+    // most one syscall.
+    const uint64_t typicalWrite = Quantile(m_writeSizes, m_writes, 0.9) + 1;
+    m_directWriteThreshold = static_cast<size_t>(std::clamp<uint64_t>(
+        std::bit_ceil(std::min<uint64_t>(typicalWrite, c_maxBufferSize)) * c_directWriteFactor,
+        c_minBufferSize / 2,
+        bufferSize / 2));
+
+    m_writeSizes = {};
+    m_writes = 0;
+    m_bufferedWrites = 0;
+    m_fullFlushes = 0;
+    m_highWater = m_used;
+
+    if (bufferSize != m_buffer.size())
+    {
+        if (m_used > bufferSize)
+        {
+            Flush();
+            m_highWater = 0;
+        }
+
+        m_buffer.resize(bufferSize);
+        m_buffer.shrink_to_fit();
+    }
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdio.h>
+#include <vector>
+
+// Buffered writes to a temp file, with a buffer size that adapts to how
+// the file is being written.
+//
+// Every c_adaptInterval writes the writer looks at how many buffered
+// writes each syscall carried. While that's below c_writesPerSyscall, the
+// buffer doubles, up to c_maxBufferSize, so small, frequent writes get
+// batched into ever fewer syscalls. If the buffer never got more than a
+// quarter full, it halves, down to c_minBufferSize.
+//
+// Separately, a histogram of write sizes picks which writes bypass the
+// buffer: those at least c_directWriteFactor times the 90th percentile
+// write size, or half the buffer size. When most writes are at least
+// c_directWriteSize, the buffer drops to c_minBufferSize and all but the
+// smallest writes go straight to the file, so bulk writers don't pay for
+// copying.
+class AdaptiveTmpFileWriter
+{
+public:
+    static constexpr size_t c_minBufferSize = 4 * 1024;
+    static constexpr size_t c_maxBufferSize = 1024 * 1024;
+    static constexpr size_t c_directWriteSize = 32 * 1024;
+    static constexpr size_t c_directWriteFactor = 32;
+    static constexpr uint32_t c_writesPerSyscall = 256;
+    static constexpr uint32_t c_adaptInterval = 256;
+
+    // Takes over buffering for file, and turns off the CRT's buffering of
+    // it. This must be done before anything is read from or written to
+    // file.
+    explicit AdaptiveTmpFileWriter(FILE* file);
+
+    // Flushes. Errors are logged, not thrown; call Flush first to see them.
+    ~AdaptiveTmpFileWriter();
+
+    AdaptiveTmpFileWriter(const AdaptiveTmpFileWriter&) = delete;
+    AdaptiveTmpFileWriter& operator=(const AdaptiveTmpFileWriter&) = delete;
+
+    void Write(std::span<const std::byte> data);
+
+    // Writes out anything buffered.
+    void Flush();
+
+    size_t GetBufferSize() const { return m_buffer.size(); }
+
+private:
+    void Adapt();
+
+    FILE* m_file;
+    std::vector<std::byte> m_buffer;
+    size_t m_used = 0;
+
+    // Writes at least this big bypass the buffer.
+    size_t m_directWriteThreshold = c_minBufferSize / 2;
+
+    // Counts of writes by the bit width of their size, since the last
+    // Adapt.
+    std::array<uint32_t, 65> m_writeSizes{};
+    uint32_t m_writes = 0;
+
+    // How the buffer was used since the last Adapt.
+    uint32_t m_bufferedWrites = 0;
+    uint32_t m_fullFlushes = 0;
+    size_t m_highWater = 0;
+};
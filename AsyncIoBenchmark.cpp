@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compares the latency of TmpFileAsyncIo's completion modes: unbuffered,
+// 4 KiB random reads from a temp file, one at a time.
+//
+// Usage: async-io-benchmark.exe [pollCpu]
+
+#include "TmpFile.h"
+#include "TmpFileAsyncIo.h"
+
+#include <windows.h>
+
+#include <wil/resource.h>
+#include <wil/result.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+static void __stdcall LogFailureToStderr(wil::FailureInfo const& failure) noexcept;
+
+namespace
+{
+    constexpr uint64_t c_fileSize = 256 * 1024 * 1024;
+    constexpr DWORD c_readSize = 4096;
+    constexpr int c_reads = 20'000;
+
+    double NowUs()
+    {
+        static const LONGLONG frequency = []()
+            {
+                LARGE_INTEGER f;
+                QueryPerformanceFrequency(&f);
+                return f.QuadPart;
+            }();
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return static_cast<double>(now.QuadPart) * 1'000'000 / frequency;
+    }
+
+    void Measure(const wchar_t* name, HANDLE tmpFileHandle, const TmpFileAsyncIo::Options& options)
+    {
+        wil::unique_virtualalloc_ptr<std::byte> buffer{
+            static_cast<std::byte*>(VirtualAlloc(nullptr, c_readSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)) };
+        THROW_LAST_ERROR_IF_NULL(buffer.get());
+
+        TmpFileAsyncIo io{ tmpFileHandle, options };
+
+        std::mt19937_64 random{ 42 };
+        std::vector<double> latenciesUs;
+        latenciesUs.reserve(c_reads);
+
+        for (int i = 0; i < c_reads; ++i)
+        {
+            const uint64_t offset = random() % (c_fileSize / c_readSize) * c_readSize;
+
+            std::atomic<bool> done{ false };
+            HRESULT result = S_OK;
+            const double start = NowUs();
+            io.ReadAsync(offset, { buffer.get(), c_readSize }, [&](HRESULT hr, DWORD)
+                {
+                    result = hr;
+                    done.store(true, std::memory_order_release);
+                });
+
+            while (!done.load(std::memory_order_acquire))
+            {
+                YieldProcessor();
+            }
+
+            latenciesUs.push_back(NowUs() - start);
+            THROW_IF_FAILED(result);
+        }
+
+        std::sort(latenciesUs.begin(), latenciesUs.end());
+        wprintf(
+            L"%-10s p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us\n",
+            name,
+            latenciesUs[latenciesUs.size() / 2],
+            latenciesUs[latenciesUs.size() * 99 / 100],
+            latenciesUs[latenciesUs.size() * 999 / 1000]);
+    }
+}
+
+int wmain(int argc, const wchar_t** argv) try
+{
+    wil::SetResultLoggingCallback(LogFailureToStderr);
+
+    std::optional<DWORD> pollCpu;
+    if (argc > 1)
+    {
+        pollCpu = static_cast<DWORD>(wcstoul(argv[1], nullptr, 10));
+    }
+
+    TmpFile tmpFile = CreateTmpFileWithPosixDelete(true);
+
+    std::vector<std::byte> chunk(1024 * 1024, std::byte{ 0x5A });
+    for (uint64_t written = 0; written < c_fileSize; written += chunk.size())
+    {
+        THROW_HR_IF(ErrnoToHresult(errno), fwrite(chunk.data(), 1, chunk.size(), tmpFile.file) != chunk.size());
+    }
+
+    THROW_HR_IF(ErrnoToHresult(errno), fflush(tmpFile.file) != 0);
+    THROW_IF_WIN32_BOOL_FALSE(FlushFileBuffers(tmpFile.handle));
+
+    Measure(L"interrupt", tmpFile.handle, { .mode = TmpFileAsyncIo::CompletionMode::Interrupt, .unbuffered = true });
+    Measure(L"busy-poll", tmpFile.handle, { .mode = TmpFileAsyncIo::CompletionMode::BusyPoll, .pollCpu = pollCpu, .unbuffered = true });
+
+    fclose(tmpFile.file);
+    return 0;
+}
+CATCH_LOG()
+
+static void __stdcall LogFailureToStderr(wil::FailureInfo const& failure) noexcept
+{
+    constexpr DWORD c_maxLogMessageSize = 2048;
+    wchar_t logMessage[c_maxLogMessageSize];
+
+    FAIL_FAST_IF_FAILED(wil::GetFailureLogString(logMessage, _countof(logMessage), failure));
+    FAIL_FAST_IF(-1 == fwprintf(stderr, L"%s", logMessage));
+}
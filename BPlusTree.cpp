@@ -0,0 +1,199 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BPlusTree.h"
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <stdio.h>
+
+BPlusTree::BPlusTree(wil::unique_file file, uint64_t rootPage, uint64_t leafCount, uint64_t size, size_t bufferPoolPages)
+    : m_file(std::move(file))
+    , m_handle(GetTmpFileHandle(m_file.get()))
+    , m_rootPage(rootPage)
+    , m_leafCount(leafCount)
+    , m_size(size)
+    , m_frames(std::make_unique<Node[]>(bufferPoolPages))
+    , m_framePages(bufferPoolPages, c_noPage)
+    , m_referenced(bufferPoolPages, false)
+{
+    THROW_HR_IF(E_INVALIDARG, bufferPoolPages == 0);
+}
+
+std::optional<uint64_t> BPlusTree::Find(uint64_t key)
+{
+    std::optional<uint64_t> found;
+    ForEachInRange(key, key, [&](uint64_t, uint64_t value)
+        {
+            found = value;
+            return false;
+        });
+    return found;
+}
+
+void BPlusTree::ForEachInRange(uint64_t low, uint64_t high, const std::function<bool(uint64_t key, uint64_t value)>& onEntry)
+{
+    for (uint64_t page = FindLeaf(low); page < m_leafCount; ++page)
+    {
+        // Leaves are stored in key order on consecutive pages, so the next
+        // leaf is always the next page. Copy the leaf out of the buffer
+        // pool, since onEntry may use the tree, which can evict it.
+        const Node leaf = GetPage(page);
+        for (size_t i = std::lower_bound(leaf.keys, leaf.keys + leaf.count, low) - leaf.keys; i < leaf.count; ++i)
+        {
+            if (leaf.keys[i] > high || !onEntry(leaf.keys[i], leaf.values[i]))
+            {
+                return;
+            }
+        }
+    }
+}
+
+uint64_t BPlusTree::FindLeaf(uint64_t key)
+{
+    uint64_t page = m_rootPage;
+    for (;;)
+    {
+        const Node& node = GetPage(page);
+        if (node.level == 0)
+        {
+            return page;
+        }
+
+        // Descend into the last child whose keys are all less than key.
+        // With duplicate keys, the first entry with key may be at the end
+        // of the child before the one whose first key is key.
+        const size_t index = std::lower_bound(node.keys, node.keys + node.count, key) - node.keys;
+        page = node.values[index == 0 ? 0 : index - 1];
+    }
+}
+
+const BPlusTree::Node& BPlusTree::GetPage(uint64_t page)
+{
+    if (auto it = m_pageToFrame.find(page); it != m_pageToFrame.end())
+    {
+        m_referenced[it->second] = true;
+        return m_frames[it->second];
+    }
+
+    // Clock eviction: skip over, and clear, recently referenced frames.
+    while (m_referenced[m_clockHand])
+    {
+        m_referenced[m_clockHand] = false;
+        m_clockHand = (m_clockHand + 1) % m_framePages.size();
+    }
+
+    const size_t frame = m_clockHand;
+    m_clockHand = (m_clockHand + 1) % m_framePages.size();
+
+    if (m_framePages[frame] != c_noPage)
+    {
+        m_pageToFrame.erase(m_framePages[frame]);
+        m_framePages[frame] = c_noPage;
+    }
+
+    const uint64_t offset = page * c_pageSize;
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD bytesRead = 0;
+    THROW_IF_WIN32_BOOL_FALSE(ReadFile(m_handle, &m_frames[frame], c_pageSize, &bytesRead, &overlapped));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT), bytesRead != c_pageSize);
+
+    m_framePages[frame] = page;
+    m_referenced[frame] = true;
+    m_pageToFrame.emplace(page, frame);
+    return m_frames[frame];
+}
+
+BPlusTreeBuilder::BPlusTreeBuilder()
+    : m_file(CreateTmpFileWithPosixDelete(true).file)
+    , m_leaf(std::make_unique<Node>())
+{
+}
+
+void BPlusTreeBuilder::Add(uint64_t key, uint64_t value)
+{
+    THROW_HR_IF(E_INVALIDARG, m_size != 0 && key < m_lastKey);
+
+    if (m_leaf->count == BPlusTree::c_fanout)
+    {
+        m_leaves.emplace_back(m_leaf->keys[0], WriteNode(*m_leaf));
+        *m_leaf = Node{};
+    }
+
+    m_leaf->keys[m_leaf->count] = key;
+    m_leaf->values[m_leaf->count] = value;
+    ++m_leaf->count;
+    ++m_size;
+    m_lastKey = key;
+}
+
+BPlusTree BPlusTreeBuilder::Finish(size_t bufferPoolPages)
+{
+    // An empty tree is a single empty leaf.
+    if (m_leaf->count != 0 || m_leaves.empty())
+    {
+        m_leaves.emplace_back(m_leaf->keys[0], WriteNode(*m_leaf));
+    }
+
+    const uint64_t leafCount = m_nextPage;
+
+    // Build each level of internal nodes from the one below it until
+    // there's only one node left: the root.
+    std::vector<std::pair<uint64_t, uint64_t>> level = std::move(m_leaves);
+    for (uint16_t height = 1; level.size() > 1; ++height)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> parents;
+        for (size_t begin = 0; begin < level.size(); begin += BPlusTree::c_fanout)
+        {
+            const size_t end = std::min(begin + BPlusTree::c_fanout, level.size());
+
+            *m_leaf = Node{};
+            m_leaf->level = height;
+            m_leaf->count = static_cast<uint16_t>(end - begin);
+            for (size_t i = begin; i < end; ++i)
+            {
+                m_leaf->keys[i - begin] = level[i].first;
+                m_leaf->values[i - begin] = level[i].second;
+            }
+
+            parents.emplace_back(m_leaf->keys[0], WriteNode(*m_leaf));
+        }
+
+        level = std::move(parents);
+    }
+
+    THROW_HR_IF(ErrnoToHresult(errno), fflush(m_file.get()) != 0);
+
+    return BPlusTree{ std::move(m_file), level.front().second, leafCount, m_size, bufferPoolPages };
+}
+
+uint64_t BPlusTreeBuilder::WriteNode(const Node& node)
+{
+    THROW_HR_IF(ErrnoToHresult(errno), fwrite(&node, sizeof(node), 1, m_file.get()) != 1);
+    return m_nextPage++;
+}
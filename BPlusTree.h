@@ -0,0 +1,142 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+// Must come before wil/resource.h for wil::unique_file.
+#include <stdio.h>
+
+#include <wil/resource.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A read-only B+tree from uint64_t keys to uint64_t values, stored in a
+// POSIX-deleted temp file, for spilled data that needs ordered range
+// lookups.
+//
+// Build one with BPlusTreeBuilder from input that is already sorted by
+// key. The tree is written bottom up in a single pass: first all the
+// leaves, in key order, then each level of internal nodes. Lookups read
+// nodes through a small buffer pool with clock eviction.
+//
+// Nodes are one page each. Keys are stored apart from values and child
+// page numbers so that searching a node only touches the cache lines
+// holding its keys. Duplicate keys are allowed.
+
+class BPlusTree
+{
+public:
+    static constexpr size_t c_pageSize = 4096;
+    static constexpr size_t c_fanout = (c_pageSize - 16) / (2 * sizeof(uint64_t));
+
+    BPlusTree(BPlusTree&&) = default;
+    BPlusTree& operator=(BPlusTree&&) = default;
+
+    // Number of entries in the tree.
+    uint64_t Size() const { return m_size; }
+
+    // Gets the value of the first entry with key, if any.
+    std::optional<uint64_t> Find(uint64_t key);
+
+    // Calls onEntry for each entry with a key in [low, high], in key order,
+    // until it returns false. onEntry may use the tree.
+    void ForEachInRange(uint64_t low, uint64_t high, const std::function<bool(uint64_t key, uint64_t value)>& onEntry);
+
+private:
+    friend class BPlusTreeBuilder;
+
+    struct alignas(c_pageSize) Node
+    {
+        // 0 for leaves.
+        uint16_t level;
+        uint16_t count;
+        uint32_t reserved1;
+        uint64_t reserved2;
+
+        uint64_t keys[c_fanout];
+
+        // Values for leaves, child page numbers for internal nodes. The
+        // child at index i holds keys >= keys[i].
+        uint64_t values[c_fanout];
+    };
+
+    static_assert(sizeof(Node) == c_pageSize);
+
+    static constexpr uint64_t c_noPage = UINT64_MAX;
+
+    BPlusTree(wil::unique_file file, uint64_t rootPage, uint64_t leafCount, uint64_t size, size_t bufferPoolPages);
+
+    uint64_t FindLeaf(uint64_t key);
+
+    // Gets a page from the buffer pool, reading it in if needed. The page
+    // is only valid until the next call.
+    const Node& GetPage(uint64_t page);
+
+    wil::unique_file m_file;
+    HANDLE m_handle;
+    uint64_t m_rootPage;
+    uint64_t m_leafCount;
+    uint64_t m_size;
+
+    // The buffer pool.
+    std::unique_ptr<Node[]> m_frames;
+    std::vector<uint64_t> m_framePages;
+    std::vector<bool> m_referenced;
+    std::unordered_map<uint64_t, size_t> m_pageToFrame;
+    size_t m_clockHand = 0;
+};
+
+class BPlusTreeBuilder
+{
+public:
+    // Creates the temp file the tree will be stored in.
+    BPlusTreeBuilder();
+
+    // Adds an entry. Keys must be added in non-decreasing order.
+    void Add(uint64_t key, uint64_t value);
+
+    // Writes the rest of the tree and opens it for lookups with a buffer
+    // pool of bufferPoolPages pages.
+    BPlusTree Finish(size_t bufferPoolPages = 64);
+
+private:
+    using Node = BPlusTree::Node;
+
+    // Appends a node to the file and returns its page number.
+    uint64_t WriteNode(const Node& node);
+
+    wil::unique_file m_file;
+    std::unique_ptr<Node> m_leaf;
+    uint64_t m_nextPage = 0;
+    uint64_t m_size = 0;
+    uint64_t m_lastKey = 0;
+
+    // The first key and page number of each leaf written so far.
+    std::vector<std::pair<uint64_t, uint64_t>> m_leaves;
+};
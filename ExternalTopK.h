@@ -0,0 +1,274 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+// Must come before wil/resource.h for wil::unique_file.
+#include <stdio.h>
+
+#include <wil/resource.h>
+#include <wil/result.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The first k items of a stream in sorted order, i.e., ORDER BY ... LIMIT k,
+// for k too big to fit in memory, without sorting the whole stream.
+//
+// Items are collected in a bounded in-memory buffer. When it fills up, it
+// is sorted and written to a POSIX-deleted temp file as a run, keeping at
+// most k items. Every run also keeps a small sample of its items in
+// memory. From the samples, a cutoff is worked out that at least k items
+// seen so far are no greater than. Any later item greater than the cutoff
+// can't be in the result, so it is dropped right away. The cutoff gets
+// tighter as more runs are written, so most of a large input is dropped
+// without being buffered or written. Finish writes what's left in the
+// buffer as one last run, and merges the runs.
+template <typename T, typename Less = std::less<T>>
+class ExternalTopK
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    // Keeps at most memoryItems items in memory at once, not counting
+    // samples.
+    ExternalTopK(uint64_t k, size_t memoryItems, Less less = {})
+        : m_k(k)
+        , m_memoryItems(std::max<size_t>(memoryItems, 2))
+        , m_sampleStride(std::max<size_t>(memoryItems / c_samplesPerRun, 1))
+        , m_less(std::move(less))
+    {
+        m_buffer.reserve(m_memoryItems);
+    }
+
+    void Add(const T& item)
+    {
+        if (m_k == 0 || (m_cutoff && m_less(*m_cutoff, item)))
+        {
+            return;
+        }
+
+        m_buffer.push_back(item);
+        if (m_buffer.size() == m_memoryItems)
+        {
+            SpillBuffer();
+        }
+    }
+
+    // Calls onItem for each of the first k items, in order.
+    void Finish(const std::function<void(const T&)>& onItem)
+    {
+        if (m_runs.empty())
+        {
+            SortAndTrimBuffer();
+            for (const T& item : m_buffer)
+            {
+                onItem(item);
+            }
+
+            return;
+        }
+
+        // Spill what's left as one more run, and free the buffer, so that
+        // the runs' read buffers can have all of the memory.
+        SpillBuffer();
+        m_buffer = std::vector<T>{};
+
+        THROW_HR_IF(ErrnoToHresult(errno), fflush(m_file.get()) != 0);
+
+        // Split the memory between the runs. Each gets a read buffer, plus
+        // a slot in the heap.
+        const size_t readItems = std::max<size_t>(m_memoryItems / m_runs.size(), 2) - 1;
+        std::vector<RunReader> readers;
+        for (const Run& run : m_runs)
+        {
+            readers.push_back(RunReader{ .next = run.offset, .remaining = run.count });
+        }
+
+        auto greater = [&](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) { return m_less(b.first, a.first); };
+        std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(greater)> heap{ greater };
+
+        auto pushNext = [&](size_t source)
+            {
+                if (std::optional<T> item = readers[source].Next(m_file.get(), readItems))
+                {
+                    heap.emplace(*item, source);
+                }
+            };
+
+        for (size_t source = 0; source < readers.size(); ++source)
+        {
+            pushNext(source);
+        }
+
+        for (uint64_t emitted = 0; emitted < m_k && !heap.empty(); ++emitted)
+        {
+            const auto [item, source] = heap.top();
+            heap.pop();
+            onItem(item);
+            pushNext(source);
+        }
+    }
+
+private:
+    static constexpr size_t c_samplesPerRun = 64;
+
+    struct Run
+    {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct Sample
+    {
+        T item;
+
+        // How many more of the run's items are known to be <= item than
+        // were for the previous sample.
+        uint64_t count;
+    };
+
+    struct RunReader
+    {
+        uint64_t next;
+        uint64_t remaining;
+        std::vector<T> buffer{};
+        size_t bufferIndex = 0;
+
+        std::optional<T> Next(FILE* file, size_t readItems)
+        {
+            if (bufferIndex == buffer.size())
+            {
+                if (remaining == 0)
+                {
+                    return std::nullopt;
+                }
+
+                buffer.resize(static_cast<size_t>(std::min<uint64_t>(readItems, remaining)));
+                bufferIndex = 0;
+                THROW_HR_IF(ErrnoToHresult(errno), _fseeki64(file, static_cast<int64_t>(next), SEEK_SET) != 0);
+                THROW_HR_IF(ErrnoToHresult(errno), fread(buffer.data(), sizeof(T), buffer.size(), file) != buffer.size());
+                next += buffer.size() * sizeof(T);
+                remaining -= buffer.size();
+            }
+
+            return buffer[bufferIndex++];
+        }
+    };
+
+    void SortAndTrimBuffer()
+    {
+        std::sort(m_buffer.begin(), m_buffer.end(), m_less);
+
+        // The cutoff may have tightened since some of these were added.
+        if (m_cutoff)
+        {
+            m_buffer.erase(
+                std::upper_bound(m_buffer.begin(), m_buffer.end(), *m_cutoff, m_less),
+                m_buffer.end());
+        }
+
+        if (m_buffer.size() > m_k)
+        {
+            m_buffer.resize(static_cast<size_t>(m_k));
+        }
+    }
+
+    void SpillBuffer()
+    {
+        SortAndTrimBuffer();
+
+        // Everything may have been past the cutoff.
+        if (m_buffer.empty())
+        {
+            return;
+        }
+
+        if (!m_file)
+        {
+            m_file.reset(CreateTmpFileWithPosixDelete(true).file);
+        }
+
+        THROW_HR_IF(ErrnoToHresult(errno), fwrite(m_buffer.data(), sizeof(T), m_buffer.size(), m_file.get()) != m_buffer.size());
+        m_runs.push_back(Run{ .offset = m_fileSize, .count = m_buffer.size() });
+        m_fileSize += m_buffer.size() * sizeof(T);
+
+        const size_t oldSamples = m_samples.size();
+        for (size_t end = m_sampleStride; end - m_sampleStride < m_buffer.size(); end += m_sampleStride)
+        {
+            const size_t sampleEnd = std::min(end, m_buffer.size());
+            m_samples.push_back(Sample{ .item = m_buffer[sampleEnd - 1], .count = sampleEnd - (end - m_sampleStride) });
+        }
+
+        // The new samples are already in order, since the run is.
+        std::inplace_merge(
+            m_samples.begin(),
+            m_samples.begin() + oldSamples,
+            m_samples.end(),
+            [&](const Sample& a, const Sample& b) { return m_less(a.item, b.item); });
+
+        m_buffer.clear();
+        TightenCutoff();
+    }
+
+    void TightenCutoff()
+    {
+        // Within a run, each sample accounts for the items since the one
+        // before it. Going through all samples in order, once they account
+        // for k items, there are at least k items <= the current sample.
+        uint64_t count = 0;
+        for (size_t i = 0; i < m_samples.size(); ++i)
+        {
+            count += m_samples[i].count;
+            if (count >= m_k)
+            {
+                m_cutoff = m_samples[i].item;
+
+                // Samples past the cutoff will never matter again.
+                m_samples.resize(i + 1);
+                return;
+            }
+        }
+    }
+
+    uint64_t m_k;
+    size_t m_memoryItems;
+    size_t m_sampleStride;
+    Less m_less;
+
+    std::optional<T> m_cutoff;
+    std::vector<T> m_buffer;
+
+    wil::unique_file m_file;
+    uint64_t m_fileSize = 0;
+    std::vector<Run> m_runs;
+    std::vector<Sample> m_samples;
+};
@@ -0,0 +1,170 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ParallelSpillScan.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // How far ahead of itself each worker prefetches.
+    constexpr uint64_t c_prefetchBytes = 4 * 1024 * 1024;
+
+    bool IsBlockStart(std::span<const std::byte> bytes, uint64_t offset)
+    {
+        const std::span<const std::byte> block = bytes.subspan(static_cast<size_t>(offset));
+        if (!SpillBlockView::IsValid(block))
+        {
+            return false;
+        }
+
+        // Record offsets are only checked in debug builds when they're
+        // used, so make sure the records at least lie between the header
+        // and the offset table. A false match could point anywhere.
+        const SpillBlockHeader& header = *reinterpret_cast<const SpillBlockHeader*>(block.data());
+        const uint32_t* recordOffsets = reinterpret_cast<const uint32_t*>(block.data() + header.offsetTable);
+        for (const uint32_t recordOffset : { recordOffsets[0], recordOffsets[header.recordCount] })
+        {
+            if (recordOffset < sizeof(SpillBlockHeader) || recordOffset > header.offsetTable)
+            {
+                return false;
+            }
+        }
+
+        // Also check that the block is followed by another block or the
+        // end of the file, to make a false match less likely.
+        const uint64_t next = offset + header.blockSize;
+        return next == bytes.size() || SpillBlockView::IsValid(bytes.subspan(static_cast<size_t>(next)));
+    }
+
+    // Finds the first block that starts at or after offset.
+    uint64_t ResyncToBlock(std::span<const std::byte> bytes, uint64_t offset)
+    {
+        offset = (offset + c_spillBlockAlignment - 1) & ~uint64_t{ c_spillBlockAlignment - 1 };
+        while (offset < bytes.size() && !IsBlockStart(bytes, offset))
+        {
+            offset += c_spillBlockAlignment;
+        }
+
+        return std::min<uint64_t>(offset, bytes.size());
+    }
+
+    std::vector<uint64_t> SplitIntoRanges(std::span<const std::byte> bytes, size_t workerCount, std::span<const uint64_t> blockIndex)
+    {
+        std::vector<uint64_t> boundaries{ 0 };
+        for (size_t i = 1; i < workerCount; ++i)
+        {
+            const uint64_t target = bytes.size() * i / workerCount;
+            if (blockIndex.empty())
+            {
+                boundaries.push_back(ResyncToBlock(bytes, target));
+            }
+            else
+            {
+                auto it = std::lower_bound(blockIndex.begin(), blockIndex.end(), target);
+                boundaries.push_back(it == blockIndex.end() ? bytes.size() : *it);
+            }
+        }
+
+        boundaries.push_back(bytes.size());
+        return boundaries;
+    }
+
+    void Prefetch(std::span<const std::byte> bytes, uint64_t begin, uint64_t end)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range{
+            .VirtualAddress = const_cast<std::byte*>(bytes.data() + begin),
+            .NumberOfBytes = static_cast<SIZE_T>(end - begin),
+        };
+
+        // This is only a hint, so failing is fine.
+        LOG_IF_WIN32_BOOL_FALSE(PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0));
+    }
+}
+
+void ParallelScanSpillFile(
+    const MappedSpillFile& file,
+    size_t workerCount,
+    const std::function<void(size_t worker, uint64_t offset, const SpillBlockView& block)>& onBlock,
+    std::span<const uint64_t> blockIndex)
+{
+    THROW_HR_IF(E_INVALIDARG, workerCount == 0);
+
+    const std::span<const std::byte> bytes = file.GetBytes();
+    const std::vector<uint64_t> boundaries = SplitIntoRanges(bytes, workerCount, blockIndex);
+
+    std::vector<std::exception_ptr> errors(workerCount);
+    auto scanRange = [&](size_t worker)
+        {
+            try
+            {
+                const uint64_t end = boundaries[worker + 1];
+                uint64_t prefetchedTo = boundaries[worker];
+                for (uint64_t offset = boundaries[worker]; offset < end;)
+                {
+                    if (offset + c_prefetchBytes / 2 >= prefetchedTo && prefetchedTo < end)
+                    {
+                        const uint64_t prefetchEnd = std::min(prefetchedTo + c_prefetchBytes, end);
+                        Prefetch(bytes, prefetchedTo, prefetchEnd);
+                        prefetchedTo = prefetchEnd;
+                    }
+
+                    const SpillBlockView block{ bytes.subspan(static_cast<size_t>(offset)) };
+                    onBlock(worker, offset, block);
+                    offset += block.Size();
+                }
+            }
+            catch (...)
+            {
+                errors[worker] = std::current_exception();
+            }
+        };
+
+    // jthreads join when destroyed, so if starting a thread fails, the
+    // ones already started are waited for instead of terminating.
+    std::vector<std::jthread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t worker = 1; worker < workerCount; ++worker)
+    {
+        threads.emplace_back(scanRange, worker);
+    }
+
+    scanRange(0);
+
+    for (std::jthread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const std::exception_ptr& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
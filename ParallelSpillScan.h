@@ -0,0 +1,47 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "SpillBlock.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+// Scans the blocks of a mapped spill file on several threads at once.
+//
+// The file is split into workerCount byte ranges that start on block
+// boundaries, and each worker calls onBlock for the blocks that start in
+// its range, in order. Workers prefetch their ranges ahead of where they
+// are reading, so the reads for all of them are in flight at once.
+//
+// If blockIndex is given, it must hold the offsets of all the blocks in
+// the file, in order, as returned by SpillBlockWriter::Flush. Range
+// boundaries are then picked from it. Otherwise, each boundary is found by
+// searching forward from an even split for a block header's sync marker.
+// Records that happen to contain a valid-looking block header can throw
+// that search off, so pass an index when one is available.
+void ParallelScanSpillFile(
+    const MappedSpillFile& file,
+    size_t workerCount,
+    const std::function<void(size_t worker, uint64_t offset, const SpillBlockView& block)>& onBlock,
+    std::span<const uint64_t> blockIndex = {});
@@ -0,0 +1,130 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RunGeneration.h"
+
+#include "RunGenerationKernels.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <array>
+
+namespace
+{
+    constexpr size_t c_buckets = 256;
+
+    bool EntryLess(const SortEntry& a, const SortEntry& b)
+    {
+        return a.keyPrefix != b.keyPrefix ? a.keyPrefix < b.keyPrefix : a.index < b.index;
+    }
+
+    using SortSmallFn = void (*)(std::span<SortEntry>);
+
+    SortSmallFn PickSortSmall()
+    {
+        if (IsProcessorFeaturePresent(PF_AVX512F_INSTRUCTIONS_AVAILABLE))
+        {
+            return SortSmallAvx512;
+        }
+
+        if (IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE))
+        {
+            return SortSmallAvx2;
+        }
+
+        return SortSmallScalar;
+    }
+
+    const SortSmallFn g_sortSmall = PickSortSmall();
+
+    // Sorts entries by (keyPrefix, index), given that they all have the
+    // same key prefix bytes above digit.
+    void SortFromDigit(std::span<SortEntry> entries, std::span<SortEntry> scratch, int digit)
+    {
+        if (entries.size() <= c_sortNetworkMaxSize)
+        {
+            g_sortSmall(entries);
+            return;
+        }
+
+        // Skip digits that every entry has the same value for. This is
+        // common for the high digits of small keys.
+        std::array<size_t, c_buckets> count;
+        for (;; --digit)
+        {
+            if (digit < 0)
+            {
+                // Every prefix is the same.
+                std::sort(entries.begin(), entries.end(), EntryLess);
+                return;
+            }
+
+            count.fill(0);
+            for (const SortEntry& entry : entries)
+            {
+                ++count[(entry.keyPrefix >> (digit * 8)) & 0xFF];
+            }
+
+            if (std::find(count.begin(), count.end(), entries.size()) == count.end())
+            {
+                break;
+            }
+        }
+
+        std::array<size_t, c_buckets> next;
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < c_buckets; ++bucket)
+        {
+            next[bucket] = offset;
+            offset += count[bucket];
+        }
+
+        for (const SortEntry& entry : entries)
+        {
+            scratch[next[(entry.keyPrefix >> (digit * 8)) & 0xFF]++] = entry;
+        }
+
+        std::copy(scratch.begin(), scratch.end(), entries.begin());
+
+        size_t begin = 0;
+        for (size_t bucket = 0; bucket < c_buckets; ++bucket)
+        {
+            if (count[bucket] > 1)
+            {
+                SortFromDigit(entries.subspan(begin, count[bucket]), scratch.subspan(begin, count[bucket]), digit - 1);
+            }
+
+            begin += count[bucket];
+        }
+    }
+}
+
+void SortSmallScalar(std::span<SortEntry> entries)
+{
+    std::sort(entries.begin(), entries.end(), EntryLess);
+}
+
+void SortByKeyPrefix(std::span<SortEntry> entries, std::span<SortEntry> scratch)
+{
+    THROW_HR_IF(E_INVALIDARG, scratch.size() < entries.size());
+    SortFromDigit(entries, scratch.first(entries.size()), static_cast<int>(sizeof(uint64_t)) - 1);
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Run generation for spilling sorted runs: sorts records in memory and
+// lays them out, in order, in a write buffer.
+//
+// Sorting wide records directly moves every record O(log n) times.
+// Instead, this sorts small (key prefix, record index) entries, only
+// compares full records to break ties between equal prefixes, and then
+// copies each record exactly once, into the write buffer.
+//
+// The entries are sorted with an MSD radix sort that hands buckets of up
+// to 64 entries to a SIMD sorting network. The network is picked at
+// startup: AVX-512 or AVX2 if the processor has it, and std::sort
+// otherwise.
+
+struct SortEntry
+{
+    // An order-preserving prefix of the record's key: if a's key sorts
+    // before b's, a's prefix must be <= b's.
+    uint64_t keyPrefix;
+
+    uint32_t index;
+    uint32_t reserved;
+};
+
+// Sorts entries by keyPrefix, then index. scratch must be at least as big
+// as entries. If entries are in index order to begin with, as GenerateRun
+// makes them, this is a stable sort by keyPrefix.
+void SortByKeyPrefix(std::span<SortEntry> entries, std::span<SortEntry> scratch);
+
+// Sorts records and appends them, in order, to out. There can be at most
+// UINT32_MAX records.
+//
+// keyPrefix(record) returns the record's key prefix. less(a, b) compares
+// full records, and is only called for records with equal prefixes.
+template <typename Record, typename KeyPrefix, typename Less>
+void GenerateRun(std::span<const Record> records, KeyPrefix keyPrefix, Less less, std::vector<std::byte>& out)
+{
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+    // Entries hold 32-bit record indexes.
+    THROW_HR_IF(E_INVALIDARG, records.size() > UINT32_MAX);
+
+    std::vector<SortEntry> entries(records.size());
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        entries[i] = SortEntry{ .keyPrefix = keyPrefix(records[i]), .index = static_cast<uint32_t>(i), .reserved = 0 };
+    }
+
+    std::vector<SortEntry> scratch(records.size());
+    SortByKeyPrefix(entries, scratch);
+
+    // Break ties between equal prefixes by comparing the full records.
+    for (size_t begin = 0; begin < entries.size();)
+    {
+        size_t end = begin + 1;
+        while (end < entries.size() && entries[end].keyPrefix == entries[begin].keyPrefix)
+        {
+            ++end;
+        }
+
+        if (end - begin > 1)
+        {
+            std::stable_sort(
+                entries.begin() + begin,
+                entries.begin() + end,
+                [&](const SortEntry& a, const SortEntry& b) { return less(records[a.index], records[b.index]); });
+        }
+
+        begin = end;
+    }
+
+    // Gather the records into the write buffer in one pass.
+    const size_t outStart = out.size();
+    out.resize(outStart + records.size() * sizeof(Record));
+    std::byte* dest = out.data() + outStart;
+    for (const SortEntry& entry : entries)
+    {
+        std::memcpy(dest, &records[entry.index], sizeof(Record));
+        dest += sizeof(Record);
+    }
+}
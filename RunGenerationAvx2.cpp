@@ -0,0 +1,175 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Uses AVX2 intrinsics. Only call into this file after checking that the
+// processor supports AVX2.
+//
+// MSVC allows the intrinsics without /arch:AVX2, and this file must not be
+// built with it: inline functions used here, like std::bit_ceil, are also
+// used by baseline code, and the linker may keep either copy.
+
+#include "RunGenerationKernels.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace
+{
+    constexpr size_t c_lanes = 4;
+
+    // Keys are stored with their top bit flipped, so that AVX2's signed
+    // compares order them as unsigned. Indexes fit in 32 bits, so they
+    // compare the same either way.
+    constexpr uint64_t c_keyBias = uint64_t{ 1 } << 63;
+
+    // Padding sorts after every real entry.
+    constexpr uint64_t c_paddingKey = UINT64_MAX ^ c_keyBias;
+    constexpr uint64_t c_paddingIndex = uint64_t{ 1 } << 32;
+
+    struct Lanes
+    {
+        __m256i key;
+        __m256i index;
+    };
+
+    // All ones in each lane where a sorts before b.
+    __m256i Less(const Lanes& a, const Lanes& b)
+    {
+        const __m256i keyLess = _mm256_cmpgt_epi64(b.key, a.key);
+        const __m256i keyEqual = _mm256_cmpeq_epi64(a.key, b.key);
+        const __m256i indexLess = _mm256_cmpgt_epi64(b.index, a.index);
+        return _mm256_or_si256(keyLess, _mm256_and_si256(keyEqual, indexLess));
+    }
+
+    Lanes Select(__m256i mask, const Lanes& ifSet, const Lanes& ifClear)
+    {
+        return Lanes{
+            .key = _mm256_blendv_epi8(ifClear.key, ifSet.key, mask),
+            .index = _mm256_blendv_epi8(ifClear.index, ifSet.index, mask),
+        };
+    }
+
+    // Swaps lanes that are j apart.
+    Lanes Partner(const Lanes& lanes, size_t j)
+    {
+        if (j == 2)
+        {
+            return Lanes{
+                .key = _mm256_permute4x64_epi64(lanes.key, 0x4E),
+                .index = _mm256_permute4x64_epi64(lanes.index, 0x4E),
+            };
+        }
+
+        return Lanes{
+            .key = _mm256_permute4x64_epi64(lanes.key, 0xB1),
+            .index = _mm256_permute4x64_epi64(lanes.index, 0xB1),
+        };
+    }
+
+    // All ones in each lane whose position, starting from i, has bit clear.
+    __m256i BitClear(size_t i, size_t bit)
+    {
+        const __m256i positions = _mm256_add_epi64(
+            _mm256_set1_epi64x(static_cast<int64_t>(i)),
+            _mm256_set_epi64x(3, 2, 1, 0));
+        const __m256i masked = _mm256_and_si256(positions, _mm256_set1_epi64x(static_cast<int64_t>(bit)));
+        return _mm256_cmpeq_epi64(masked, _mm256_setzero_si256());
+    }
+}
+
+void SortSmallAvx2(std::span<SortEntry> entries)
+{
+    const size_t size = std::max(std::bit_ceil(entries.size()), c_lanes);
+
+    alignas(32) std::array<uint64_t, c_sortNetworkMaxSize> keys;
+    alignas(32) std::array<uint64_t, c_sortNetworkMaxSize> indexes;
+    for (size_t i = 0; i < size; ++i)
+    {
+        keys[i] = i < entries.size() ? entries[i].keyPrefix ^ c_keyBias : c_paddingKey;
+        indexes[i] = i < entries.size() ? entries[i].index : c_paddingIndex;
+    }
+
+    auto load = [&](size_t i)
+        {
+            return Lanes{
+                .key = _mm256_load_si256(reinterpret_cast<const __m256i*>(&keys[i])),
+                .index = _mm256_load_si256(reinterpret_cast<const __m256i*>(&indexes[i])),
+            };
+        };
+
+    auto store = [&](size_t i, const Lanes& lanes)
+        {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&keys[i]), lanes.key);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&indexes[i]), lanes.index);
+        };
+
+    // A bitonic sorting network. Each compare-exchange puts the smaller
+    // entry first if bit k of its position is clear, and last otherwise.
+    for (size_t k = 2; k <= size; k *= 2)
+    {
+        for (size_t j = k / 2; j > 0; j /= 2)
+        {
+            for (size_t i = 0; i < size; i += c_lanes)
+            {
+                if (j >= c_lanes)
+                {
+                    // Compare whole registers j apart. k > j, so bit k is
+                    // the same for every lane.
+                    if ((i & j) != 0)
+                    {
+                        continue;
+                    }
+
+                    const Lanes a = load(i);
+                    const Lanes b = load(i + j);
+                    __m256i aFirst = Less(a, b);
+                    if ((i & k) != 0)
+                    {
+                        aFirst = _mm256_xor_si256(aFirst, _mm256_set1_epi64x(-1));
+                    }
+
+                    store(i, Select(aFirst, a, b));
+                    store(i + j, Select(aFirst, b, a));
+                }
+                else
+                {
+                    // Compare lanes within a register. A lane keeps its
+                    // entry if it's the smaller of the pair and belongs
+                    // first, or the larger and belongs last.
+                    const Lanes lanes = load(i);
+                    const Lanes partner = Partner(lanes, j);
+                    const __m256i keep = _mm256_xor_si256(
+                        Less(lanes, partner),
+                        _mm256_xor_si256(BitClear(i, j), BitClear(i, k)));
+                    store(i, Select(keep, lanes, partner));
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i] = SortEntry{ .keyPrefix = keys[i] ^ c_keyBias, .index = static_cast<uint32_t>(indexes[i]), .reserved = 0 };
+    }
+}
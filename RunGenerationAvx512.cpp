@@ -0,0 +1,165 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Uses AVX-512F intrinsics. Only call into this file after checking that the
+// processor supports AVX-512F.
+//
+// MSVC allows the intrinsics without /arch:AVX512, and this file must not be
+// built with it: inline functions used here, like std::bit_ceil, are also
+// used by baseline code, and the linker may keep either copy.
+
+#include "RunGenerationKernels.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace
+{
+    constexpr size_t c_lanes = 8;
+
+    // Padding sorts after every real entry, since indexes fit in 32 bits.
+    constexpr uint64_t c_paddingKey = UINT64_MAX;
+    constexpr uint64_t c_paddingIndex = uint64_t{ 1 } << 32;
+
+    struct Lanes
+    {
+        __m512i key;
+        __m512i index;
+    };
+
+    // Set for each lane where a sorts before b.
+    __mmask8 Less(const Lanes& a, const Lanes& b)
+    {
+        const __mmask8 keyLess = _mm512_cmplt_epu64_mask(a.key, b.key);
+        const __mmask8 keyEqual = _mm512_cmpeq_epu64_mask(a.key, b.key);
+        const __mmask8 indexLess = _mm512_cmplt_epu64_mask(a.index, b.index);
+        return keyLess | (keyEqual & indexLess);
+    }
+
+    Lanes Select(__mmask8 mask, const Lanes& ifSet, const Lanes& ifClear)
+    {
+        return Lanes{
+            .key = _mm512_mask_blend_epi64(mask, ifClear.key, ifSet.key),
+            .index = _mm512_mask_blend_epi64(mask, ifClear.index, ifSet.index),
+        };
+    }
+
+    // Swaps lanes that are j apart.
+    Lanes Partner(const Lanes& lanes, size_t j)
+    {
+        switch (j)
+        {
+        case 4:
+            return Lanes{
+                .key = _mm512_shuffle_i64x2(lanes.key, lanes.key, 0x4E),
+                .index = _mm512_shuffle_i64x2(lanes.index, lanes.index, 0x4E),
+            };
+        case 2:
+            return Lanes{
+                .key = _mm512_permutex_epi64(lanes.key, 0x4E),
+                .index = _mm512_permutex_epi64(lanes.index, 0x4E),
+            };
+        default:
+            return Lanes{
+                .key = _mm512_permutex_epi64(lanes.key, 0xB1),
+                .index = _mm512_permutex_epi64(lanes.index, 0xB1),
+            };
+        }
+    }
+
+    // Set for each lane whose position, starting from i, has bit clear.
+    __mmask8 BitClear(size_t i, size_t bit)
+    {
+        const __m512i positions = _mm512_add_epi64(
+            _mm512_set1_epi64(static_cast<int64_t>(i)),
+            _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+        return _mm512_testn_epi64_mask(positions, _mm512_set1_epi64(static_cast<int64_t>(bit)));
+    }
+}
+
+void SortSmallAvx512(std::span<SortEntry> entries)
+{
+    const size_t size = std::max(std::bit_ceil(entries.size()), c_lanes);
+
+    alignas(64) std::array<uint64_t, c_sortNetworkMaxSize> keys;
+    alignas(64) std::array<uint64_t, c_sortNetworkMaxSize> indexes;
+    for (size_t i = 0; i < size; ++i)
+    {
+        keys[i] = i < entries.size() ? entries[i].keyPrefix : c_paddingKey;
+        indexes[i] = i < entries.size() ? entries[i].index : c_paddingIndex;
+    }
+
+    auto load = [&](size_t i)
+        {
+            return Lanes{ .key = _mm512_load_si512(&keys[i]), .index = _mm512_load_si512(&indexes[i]) };
+        };
+
+    auto store = [&](size_t i, const Lanes& lanes)
+        {
+            _mm512_store_si512(&keys[i], lanes.key);
+            _mm512_store_si512(&indexes[i], lanes.index);
+        };
+
+    // The same bitonic sorting network as SortSmallAvx2, eight lanes at a
+    // time.
+    for (size_t k = 2; k <= size; k *= 2)
+    {
+        for (size_t j = k / 2; j > 0; j /= 2)
+        {
+            for (size_t i = 0; i < size; i += c_lanes)
+            {
+                if (j >= c_lanes)
+                {
+                    if ((i & j) != 0)
+                    {
+                        continue;
+                    }
+
+                    const Lanes a = load(i);
+                    const Lanes b = load(i + j);
+                    __mmask8 aFirst = Less(a, b);
+                    if ((i & k) != 0)
+                    {
+                        aFirst = static_cast<__mmask8>(~aFirst);
+                    }
+
+                    store(i, Select(aFirst, a, b));
+                    store(i + j, Select(aFirst, b, a));
+                }
+                else
+                {
+                    const Lanes lanes = load(i);
+                    const Lanes partner = Partner(lanes, j);
+                    const __mmask8 keep = Less(lanes, partner) ^ BitClear(i, j) ^ BitClear(i, k);
+                    store(i, Select(keep, lanes, partner));
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i] = SortEntry{ .keyPrefix = keys[i], .index = static_cast<uint32_t>(indexes[i]), .reserved = 0 };
+    }
+}
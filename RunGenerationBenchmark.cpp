@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compares GenerateRun against sorting the records with std::sort and
+// then copying them into a write buffer.
+
+#include "RunGeneration.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+    // A wide record, like a row of a few columns.
+    struct Record
+    {
+        uint64_t key;
+        uint64_t tieBreaker;
+        std::byte payload[112];
+    };
+
+    template <typename F>
+    double TimeMs(F&& f)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool Less(const Record& a, const Record& b)
+    {
+        return a.key != b.key ? a.key < b.key : a.tieBreaker < b.tieBreaker;
+    }
+}
+
+int wmain()
+{
+    constexpr int c_iterations = 5;
+
+    std::mt19937_64 random{ 42 };
+
+    wprintf(L"%10s %16s %16s\n", L"records", L"std::sort (ms)", L"GenerateRun (ms)");
+    for (size_t count : { 10'000, 100'000, 1'000'000 })
+    {
+        std::vector<Record> records(count);
+        for (Record& record : records)
+        {
+            record.key = random();
+            record.tieBreaker = random();
+        }
+
+        // Give each side its own output buffer, already allocated and
+        // faulted in, so that neither is timing the allocator. Both append
+        // to an empty buffer, as a spill would.
+        const size_t outSize = count * sizeof(Record);
+        std::vector<std::byte> stdSortOut(outSize);
+        std::vector<std::byte> generateRunOut(outSize);
+
+        double stdSortMs = 0;
+        double generateRunMs = 0;
+        for (int i = 0; i < c_iterations; ++i)
+        {
+            std::vector<Record> copy = records;
+            stdSortOut.clear();
+            stdSortMs += TimeMs([&]()
+                {
+                    std::sort(copy.begin(), copy.end(), Less);
+                    stdSortOut.resize(outSize);
+                    std::memcpy(stdSortOut.data(), copy.data(), outSize);
+                });
+
+            generateRunOut.clear();
+            generateRunMs += TimeMs([&]()
+                {
+                    GenerateRun(
+                        std::span<const Record>{ records },
+                        [](const Record& record) { return record.key; },
+                        Less,
+                        generateRunOut);
+                });
+        }
+
+        if (generateRunOut.size() != outSize || std::memcmp(stdSortOut.data(), generateRunOut.data(), outSize) != 0)
+        {
+            wprintf(L"GenerateRun's output doesn't match std::sort's for %zu records\n", count);
+            return 1;
+        }
+
+        wprintf(L"%10zu %16.2f %16.2f\n", count, stdSortMs / c_iterations, generateRunMs / c_iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SharedScratchArena.h"
+
+#include <windows.h>
+#include <sddl.h>
+
+#include <wil/result.h>
+
+#include <utility>
+
+namespace
+{
+    // Goes at the start of the section, so that processes it's shared
+    // with know how much data there is.
+    struct ArenaHeader
+    {
+        uint64_t magic;
+        uint64_t size;
+    };
+
+    constexpr uint64_t c_arenaMagic = 0x414E455241484353; // "SCHARENA"
+
+    // Keep the data cache line aligned.
+    constexpr size_t c_dataOffset = 64;
+
+    static_assert(sizeof(ArenaHeader) <= c_dataOffset);
+
+    // Sealed handles can map the section for reading, and nothing else.
+    constexpr DWORD c_readOnlyAccess = SECTION_MAP_READ | SECTION_QUERY;
+
+    // Grants c_readOnlyAccess and nothing more. The OWNER RIGHTS entry
+    // takes away the owner's implicit right to change the DACL, and the
+    // DACL is protected from inheriting anything.
+    constexpr PCWSTR c_readOnlySddl = L"D:P(A;;0x5;;;OW)(A;;0x5;;;WD)";
+    static_assert(c_readOnlyAccess == 0x5);
+}
+
+SharedScratchArena::SharedScratchArena(wil::unique_handle section)
+    : m_section(std::move(section))
+{
+    m_view.reset(static_cast<std::byte*>(MapViewOfFile(m_section.get(), FILE_MAP_READ, 0, 0, 0)));
+    THROW_LAST_ERROR_IF_NULL(m_view.get());
+
+    MEMORY_BASIC_INFORMATION info;
+    THROW_LAST_ERROR_IF(VirtualQuery(m_view.get(), &info, sizeof(info)) == 0);
+
+    const ArenaHeader& header = *reinterpret_cast<const ArenaHeader*>(m_view.get());
+    THROW_HR_IF(E_INVALIDARG, info.RegionSize < c_dataOffset || header.magic != c_arenaMagic);
+    THROW_HR_IF(E_INVALIDARG, header.size > info.RegionSize - c_dataOffset);
+
+    m_data = { m_view.get() + c_dataOffset, static_cast<size_t>(header.size) };
+}
+
+HANDLE SharedScratchArena::ShareWith(HANDLE targetProcess) const
+{
+    HANDLE targetHandle = nullptr;
+    THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(
+        GetCurrentProcess(),
+        m_section.get(),
+        targetProcess,
+        &targetHandle,
+        c_readOnlyAccess,
+        FALSE,
+        0));
+    return targetHandle;
+}
+
+SharedScratchArenaBuilder::SharedScratchArenaBuilder(size_t size)
+{
+    const uint64_t sectionSize = uint64_t{ size } + c_dataOffset;
+
+    // Duplicating a handle with more access than it has checks the
+    // section's DACL. The default DACL gives the creating user full
+    // access, which would let any handle to the arena be turned back into
+    // a writable one. The creator's own handle gets full access anyway,
+    // since access isn't checked when an object is created.
+    wil::unique_hlocal_security_descriptor securityDescriptor;
+    THROW_IF_WIN32_BOOL_FALSE(ConvertStringSecurityDescriptorToSecurityDescriptorW(
+        c_readOnlySddl,
+        SDDL_REVISION_1,
+        securityDescriptor.put(),
+        nullptr));
+
+    SECURITY_ATTRIBUTES securityAttributes{
+        .nLength = sizeof(securityAttributes),
+        .lpSecurityDescriptor = securityDescriptor.get(),
+        .bInheritHandle = FALSE,
+    };
+
+    // INVALID_HANDLE_VALUE makes a section backed by the pagefile rather
+    // than by a file.
+    m_section.reset(CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        &securityAttributes,
+        PAGE_READWRITE,
+        static_cast<DWORD>(sectionSize >> 32),
+        static_cast<DWORD>(sectionSize),
+        nullptr));
+    THROW_LAST_ERROR_IF(!m_section.is_valid());
+
+    m_view.reset(static_cast<std::byte*>(MapViewOfFile(m_section.get(), FILE_MAP_WRITE, 0, 0, 0)));
+    THROW_LAST_ERROR_IF_NULL(m_view.get());
+
+    *reinterpret_cast<ArenaHeader*>(m_view.get()) = ArenaHeader{ .magic = c_arenaMagic, .size = size };
+    m_data = { m_view.get() + c_dataOffset, size };
+}
+
+SharedScratchArena SharedScratchArenaBuilder::Seal()
+{
+    // Swap the read-write handle for a read-only one. Once the writable
+    // view is gone too, nothing can write to the section any more.
+    wil::unique_handle readOnly;
+    THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(
+        GetCurrentProcess(),
+        m_section.get(),
+        GetCurrentProcess(),
+        readOnly.put(),
+        c_readOnlyAccess,
+        FALSE,
+        0));
+
+    m_data = {};
+    m_view.reset();
+    m_section.reset();
+
+    return SharedScratchArena{ std::move(readOnly) };
+}
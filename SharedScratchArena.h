@@ -0,0 +1,90 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <wil/resource.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Read-only scratch data, like a dictionary built during a query, shared
+// by every process on the machine that needs it, with only one copy in
+// memory.
+//
+// Windows has no memfd or file seals. The equivalent used here is a
+// pagefile-backed section. One process builds the data in a writable view
+// with SharedScratchArenaBuilder, and then seals it: the writable view and
+// the only handle with write access are closed, leaving a handle that can
+// only map the section for reading. ShareWith hands other processes
+// read-only handles to it.
+//
+// Duplicating a handle with more access than it already has is checked
+// against the section's security descriptor. The section is created with
+// one that grants only read access, to everyone including its owner, and
+// pagefile-backed sections can't change size. So after sealing, nobody
+// can write, grow, or shrink the arena, short of taking ownership of it
+// with SeTakeOwnershipPrivilege.
+//
+// Like any section, the arena is freed when the last handle to it and the
+// last view of it are closed, including when processes exit or crash.
+// Nothing is left behind on disk.
+class SharedScratchArena
+{
+public:
+    // Maps an arena from a handle shared with this process by ShareWith.
+    // Takes ownership of the handle.
+    explicit SharedScratchArena(wil::unique_handle section);
+
+    std::span<const std::byte> GetData() const { return m_data; }
+
+    // Duplicates a read-only handle to the arena into targetProcess, which
+    // must have been opened with PROCESS_DUP_HANDLE. Returns the handle's
+    // value in targetProcess, to be passed to it by some other means.
+    HANDLE ShareWith(HANDLE targetProcess) const;
+
+private:
+    wil::unique_handle m_section;
+    wil::unique_mapview_ptr<std::byte> m_view;
+    std::span<const std::byte> m_data;
+};
+
+class SharedScratchArenaBuilder
+{
+public:
+    explicit SharedScratchArenaBuilder(size_t size);
+
+    SharedScratchArenaBuilder(const SharedScratchArenaBuilder&) = delete;
+    SharedScratchArenaBuilder& operator=(const SharedScratchArenaBuilder&) = delete;
+
+    // Where to build the data. Only valid until Seal.
+    std::span<std::byte> GetData() const { return m_data; }
+
+    // Makes the arena read-only for good and maps it for reading.
+    SharedScratchArena Seal();
+
+private:
+    wil::unique_handle m_section;
+    wil::unique_mapview_ptr<std::byte> m_view;
+    std::span<std::byte> m_data;
+};
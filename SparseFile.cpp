@@ -0,0 +1,218 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SparseFile.h"
+
+#include "TmpFile.h"
+
+#include <windows.h>
+#include <winioctl.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Positional reads on a synchronous HANDLE move its file pointer, which
+    // the CRT relies on for the FILE*'s position. Put it back when done.
+    class FilePointerRestorer
+    {
+    public:
+        explicit FilePointerRestorer(HANDLE h)
+            : m_h(h)
+        {
+            THROW_IF_WIN32_BOOL_FALSE(SetFilePointerEx(m_h, LARGE_INTEGER{}, &m_position, FILE_CURRENT));
+        }
+
+        ~FilePointerRestorer()
+        {
+            LOG_IF_WIN32_BOOL_FALSE(SetFilePointerEx(m_h, m_position, nullptr, FILE_BEGIN));
+        }
+
+        FilePointerRestorer(const FilePointerRestorer&) = delete;
+        FilePointerRestorer& operator=(const FilePointerRestorer&) = delete;
+
+    private:
+        HANDLE m_h;
+        LARGE_INTEGER m_position{};
+    };
+
+    uint64_t GetSize(HANDLE h)
+    {
+        LARGE_INTEGER size;
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(h, &size));
+        return static_cast<uint64_t>(size.QuadPart);
+    }
+
+    void ReadExactlyAt(HANDLE h, uint64_t offset, std::span<std::byte> buffer)
+    {
+        while (!buffer.empty())
+        {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+            const DWORD toRead = static_cast<DWORD>(std::min<size_t>(buffer.size(), MAXDWORD));
+            DWORD bytesRead = 0;
+            THROW_IF_WIN32_BOOL_FALSE(ReadFile(h, buffer.data(), toRead, &bytesRead, &overlapped));
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), bytesRead == 0);
+
+            offset += bytesRead;
+            buffer = buffer.subspan(bytesRead);
+        }
+    }
+
+    void FlushStream(FILE* file)
+    {
+        THROW_HR_IF(ErrnoToHresult(errno), fflush(file) != 0);
+    }
+}
+
+void MakeSparse(HANDLE h)
+{
+    DWORD bytesReturned = 0;
+    THROW_IF_WIN32_BOOL_FALSE(DeviceIoControl(h, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytesReturned, nullptr));
+}
+
+void PunchHole(HANDLE h, uint64_t offset, uint64_t length)
+{
+    FILE_ZERO_DATA_INFORMATION zeroData{};
+    zeroData.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+    zeroData.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(offset + length);
+
+    DWORD bytesReturned = 0;
+    THROW_IF_WIN32_BOOL_FALSE(DeviceIoControl(h, FSCTL_SET_ZERO_DATA, &zeroData, sizeof(zeroData), nullptr, 0, &bytesReturned, nullptr));
+}
+
+std::vector<FileRange> QueryDataRanges(HANDLE h, uint64_t offset, uint64_t length)
+{
+    std::vector<FileRange> ranges;
+    const uint64_t end = offset + length;
+
+    while (offset < end)
+    {
+        FILE_ALLOCATED_RANGE_BUFFER query{};
+        query.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+        query.Length.QuadPart = static_cast<LONGLONG>(end - offset);
+
+        FILE_ALLOCATED_RANGE_BUFFER results[64];
+        DWORD bytesReturned = 0;
+        const BOOL complete = DeviceIoControl(
+            h,
+            FSCTL_QUERY_ALLOCATED_RANGES,
+            &query,
+            sizeof(query),
+            results,
+            sizeof(results),
+            &bytesReturned,
+            nullptr);
+        THROW_LAST_ERROR_IF(!complete && GetLastError() != ERROR_MORE_DATA);
+
+        const DWORD count = bytesReturned / sizeof(results[0]);
+        for (DWORD i = 0; i < count; ++i)
+        {
+            ranges.push_back(FileRange{
+                .offset = static_cast<uint64_t>(results[i].FileOffset.QuadPart),
+                .length = static_cast<uint64_t>(results[i].Length.QuadPart),
+            });
+        }
+
+        if (complete || count == 0)
+        {
+            break;
+        }
+
+        // ERROR_MORE_DATA: continue after the last range we got.
+        offset = ranges.back().offset + ranges.back().length;
+    }
+
+    return ranges;
+}
+
+size_t ReadSparse(FILE* file, uint64_t offset, std::span<std::byte> buffer)
+{
+    FlushStream(file);
+
+    const HANDLE h = GetTmpFileHandle(file);
+    const uint64_t size = GetSize(h);
+    if (offset >= size)
+    {
+        return 0;
+    }
+
+    const size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), size - offset));
+    buffer = buffer.first(length);
+
+    FilePointerRestorer restorer{ h };
+
+    uint64_t position = offset;
+    for (const FileRange& range : QueryDataRanges(h, offset, length))
+    {
+        const uint64_t dataBegin = std::max(range.offset, position);
+        const uint64_t dataEnd = std::min(range.offset + range.length, offset + length);
+        if (dataBegin >= dataEnd)
+        {
+            continue;
+        }
+
+        // Synthesize the hole before this range.
+        std::memset(buffer.data() + (position - offset), 0, static_cast<size_t>(dataBegin - position));
+
+        ReadExactlyAt(
+            h,
+            dataBegin,
+            buffer.subspan(static_cast<size_t>(dataBegin - offset), static_cast<size_t>(dataEnd - dataBegin)));
+        position = dataEnd;
+    }
+
+    // Synthesize the hole at the end, if any.
+    std::memset(buffer.data() + (position - offset), 0, static_cast<size_t>(offset + length - position));
+
+    return length;
+}
+
+void ScanDataRanges(
+    FILE* file,
+    std::span<std::byte> scratch,
+    const std::function<void(uint64_t offset, std::span<const std::byte> data)>& onData)
+{
+    THROW_HR_IF(E_INVALIDARG, scratch.empty());
+
+    FlushStream(file);
+
+    const HANDLE h = GetTmpFileHandle(file);
+    const uint64_t size = GetSize(h);
+
+    FilePointerRestorer restorer{ h };
+
+    for (const FileRange& range : QueryDataRanges(h, 0, size))
+    {
+        const uint64_t rangeEnd = std::min(range.offset + range.length, size);
+        for (uint64_t position = range.offset; position < rangeEnd;)
+        {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(scratch.size(), rangeEnd - position));
+            ReadExactlyAt(h, position, scratch.first(chunk));
+            onData(position, scratch.first(chunk));
+            position += chunk;
+        }
+    }
+}
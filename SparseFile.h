@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdio.h>
+#include <vector>
+
+// Sparse-aware access to temp files.
+//
+// Windows has no lseek(SEEK_DATA/SEEK_HOLE). The NTFS equivalent is
+// FSCTL_QUERY_ALLOCATED_RANGES, which reports the ranges of a sparse file
+// that are backed by disk. Everything else is a hole that reads as zeros,
+// so these functions fill holes in without issuing any reads, or skip them
+// entirely.
+//
+// Only files that have been marked sparse have holes. For other files the
+// whole file is reported as one data range, and these functions behave
+// like plain reads.
+
+struct FileRange
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Marks the file as sparse, so that ranges that are never written, or that
+// are punched out with PunchHole, don't take up any disk space.
+void MakeSparse(HANDLE h);
+
+// Deallocates [offset, offset + length) of a sparse file. The range reads
+// as zeros afterwards.
+void PunchHole(HANDLE h, uint64_t offset, uint64_t length);
+
+// Gets the data (allocated) ranges of h within [offset, offset + length).
+std::vector<FileRange> QueryDataRanges(HANDLE h, uint64_t offset, uint64_t length);
+
+// Reads up to buffer.size() bytes starting at offset. Holes are filled with
+// zeros without reading them. Returns the number of bytes read, which is
+// less than buffer.size() only at the end of the file.
+//
+// Any data buffered in file is flushed first. The stream's position is not
+// changed.
+size_t ReadSparse(FILE* file, uint64_t offset, std::span<std::byte> buffer);
+
+// Calls onData for every chunk of data in the file, in order, skipping
+// holes. Each chunk is at most scratch.size() bytes and is only valid for
+// the duration of the call.
+//
+// Any data buffered in file is flushed first. The stream's position is not
+// changed.
+void ScanDataRanges(
+    FILE* file,
+    std::span<std::byte> scratch,
+    const std::function<void(uint64_t offset, std::span<const std::byte> data)>& onData);
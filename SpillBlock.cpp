@@ -0,0 +1,191 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SpillBlock.h"
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/resource.h>
+#include <wil/result.h>
+
+#include <limits>
+
+SpillBlockWriter::SpillBlockWriter(FILE* file)
+    : m_file(file)
+{
+    m_block.resize(sizeof(SpillBlockHeader));
+}
+
+size_t SpillBlockWriter::BeginRecord()
+{
+    Pad(c_spillRecordAlignment);
+    m_recordOffsets.push_back(static_cast<uint32_t>(m_block.size()));
+    return m_block.size();
+}
+
+void SpillBlockWriter::AppendFields(size_t recordStart, std::initializer_list<std::span<const std::byte>> fields)
+{
+    Pad(alignof(uint32_t));
+
+    // Reserve the field offset table, then fill it in as the fields are
+    // appended.
+    const size_t tableStart = m_block.size();
+    m_block.resize(tableStart + (fields.size() + 1) * sizeof(uint32_t));
+
+    size_t index = 0;
+    auto setOffset = [&]()
+        {
+            const uint32_t offset = static_cast<uint32_t>(m_block.size() - recordStart);
+            std::memcpy(m_block.data() + tableStart + index * sizeof(uint32_t), &offset, sizeof(offset));
+            ++index;
+        };
+
+    for (std::span<const std::byte> field : fields)
+    {
+        setOffset();
+        AppendBytes(field);
+    }
+
+    setOffset();
+}
+
+void SpillBlockWriter::AppendBytes(std::span<const std::byte> bytes)
+{
+    m_block.insert(m_block.end(), bytes.begin(), bytes.end());
+}
+
+void SpillBlockWriter::Pad(size_t alignment)
+{
+    m_block.resize((m_block.size() + alignment - 1) & ~(alignment - 1));
+}
+
+uint64_t SpillBlockWriter::Flush()
+{
+    const int64_t offset = _ftelli64(m_file);
+    THROW_HR_IF(ErrnoToHresult(errno), offset == -1);
+
+    // Blocks must be written back to back from the start of the file so
+    // that they stay aligned.
+    THROW_HR_IF(E_UNEXPECTED, offset % c_spillBlockAlignment != 0);
+
+    // If anything below fails, put the pending records back the way they
+    // were, and the file position back to the start of the block, so that
+    // Flush can be retried.
+    const size_t pendingBytes = m_block.size();
+    const size_t recordCount = m_recordOffsets.size();
+    auto restoreOnFailure = wil::scope_exit([&]()
+        {
+            m_block.resize(pendingBytes);
+            m_recordOffsets.resize(recordCount);
+            _fseeki64(m_file, offset, SEEK_SET);
+        });
+
+    Pad(alignof(uint32_t));
+    const size_t offsetTable = m_block.size();
+    m_recordOffsets.push_back(static_cast<uint32_t>(offsetTable));
+    AppendBytes(std::as_bytes(std::span{ m_recordOffsets }));
+    Pad(c_spillBlockAlignment);
+
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW), m_block.size() > std::numeric_limits<uint32_t>::max());
+
+    const SpillBlockHeader header{
+        .syncMarker = c_spillBlockSyncMarker,
+        .blockSize = static_cast<uint32_t>(m_block.size()),
+        .recordCount = static_cast<uint32_t>(recordCount),
+        .offsetTable = static_cast<uint32_t>(offsetTable),
+        .reserved = 0,
+    };
+    std::memcpy(m_block.data(), &header, sizeof(header));
+
+    THROW_HR_IF(ErrnoToHresult(errno), fwrite(m_block.data(), 1, m_block.size(), m_file) != m_block.size());
+    restoreOnFailure.release();
+
+    m_block.resize(sizeof(SpillBlockHeader));
+    m_recordOffsets.clear();
+    return static_cast<uint64_t>(offset);
+}
+
+SpillBlockView::SpillBlockView(std::span<const std::byte> bytes)
+{
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT), !IsValid(bytes));
+
+    const SpillBlockHeader& header = *reinterpret_cast<const SpillBlockHeader*>(bytes.data());
+    m_block = bytes.first(header.blockSize);
+}
+
+bool SpillBlockView::IsValid(std::span<const std::byte> bytes)
+{
+    if (bytes.size() < sizeof(SpillBlockHeader))
+    {
+        return false;
+    }
+
+    const SpillBlockHeader& header = *reinterpret_cast<const SpillBlockHeader*>(bytes.data());
+    return header.syncMarker == c_spillBlockSyncMarker &&
+        header.blockSize <= bytes.size() &&
+        header.blockSize % c_spillBlockAlignment == 0 &&
+        header.offsetTable >= sizeof(SpillBlockHeader) &&
+        header.offsetTable <= header.blockSize &&
+        header.offsetTable % alignof(uint32_t) == 0 &&
+        (header.blockSize - header.offsetTable) / sizeof(uint32_t) >= uint64_t{ header.recordCount } + 1;
+}
+
+std::span<const std::byte> SpillBlockView::GetRecord(uint32_t index) const
+{
+    WI_ASSERT(index < RecordCount());
+
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(m_block.data() + Header().offsetTable);
+    const uint32_t begin = offsets[index];
+    const uint32_t end = offsets[index + 1];
+    WI_ASSERT(begin <= end && end <= Header().offsetTable);
+    return m_block.subspan(begin, end - begin);
+}
+
+MappedSpillFile::MappedSpillFile(FILE* file)
+{
+    THROW_HR_IF(ErrnoToHresult(errno), fflush(file) != 0);
+
+    const HANDLE h = GetTmpFileHandle(file);
+
+    LARGE_INTEGER size;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(h, &size));
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // Empty files can't be mapped, but then there's nothing to read
+    // anyway.
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    m_mapping.reset(CreateFileMappingW(h, nullptr, PAGE_READONLY, size.HighPart, size.LowPart, nullptr));
+    THROW_LAST_ERROR_IF(!m_mapping.is_valid());
+
+    m_view.reset(static_cast<std::byte*>(MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, m_size)));
+    THROW_LAST_ERROR_IF_NULL(m_view.get());
+}
+
+SpillBlockView MappedSpillFile::GetBlockAt(uint64_t offset) const
+{
+    THROW_HR_IF(E_BOUNDS, offset >= m_size);
+    return SpillBlockView{ GetBytes().subspan(static_cast<size_t>(offset)) };
+}
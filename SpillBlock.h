@@ -0,0 +1,212 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <wil/resource.h>
+#include <wil/result_macros.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <stdio.h>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// A block format for records spilled to temp files, and read-only views
+// that read the records in place from a mapping of the file. Reading a
+// spilled record back doesn't involve copying or parsing it.
+//
+// A block is:
+//
+//     SpillBlockHeader
+//     records, each starting at a multiple of c_spillRecordAlignment
+//     uint32_t offsets[recordCount + 1], relative to the start of the block
+//     padding to a multiple of c_spillBlockAlignment
+//
+// A record is a fixed-size, trivially copyable part followed by a table of
+// fieldCount + 1 uint32_t offsets, relative to the start of the record, and
+// then the bytes of its variable-length fields.
+//
+// Blocks are written back to back starting at offset 0 of the file, so
+// every block starts at a multiple of c_spillBlockAlignment.
+//
+// Bounds and alignment checks on record and field accesses are done in
+// debug builds only. Block headers are always checked.
+
+inline constexpr uint64_t c_spillBlockSyncMarker = 0x4B434F4C424C5053; // "SPLBLOCK"
+inline constexpr size_t c_spillBlockAlignment = 64;
+inline constexpr size_t c_spillRecordAlignment = 8;
+
+struct SpillBlockHeader
+{
+    // Always c_spillBlockSyncMarker. Lets readers find the start of a block.
+    uint64_t syncMarker;
+
+    // Size of the whole block, including this header and padding.
+    uint32_t blockSize;
+
+    uint32_t recordCount;
+
+    // Offset of the record offset table from the start of the block.
+    uint32_t offsetTable;
+
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SpillBlockHeader) % c_spillRecordAlignment == 0);
+
+// Accumulates records in memory and writes them to a temp file as blocks.
+class SpillBlockWriter
+{
+public:
+    explicit SpillBlockWriter(FILE* file);
+
+    // Appends a record to the pending block. fields must have the same
+    // number of elements for every record of a given type.
+    template <typename Fixed>
+    void Append(const Fixed& fixed, std::initializer_list<std::span<const std::byte>> fields)
+    {
+        static_assert(std::is_trivially_copyable_v<Fixed>);
+        static_assert(alignof(Fixed) <= c_spillRecordAlignment);
+
+        const size_t recordStart = BeginRecord();
+        AppendBytes(std::as_bytes(std::span{ &fixed, 1 }));
+        AppendFields(recordStart, fields);
+    }
+
+    // Bytes in the pending block so far. Use this to decide when to Flush.
+    size_t PendingBytes() const { return m_block.size(); }
+
+    // Writes the pending records as a block at the current position of the
+    // file. Returns the offset of the block.
+    uint64_t Flush();
+
+private:
+    size_t BeginRecord();
+    void AppendFields(size_t recordStart, std::initializer_list<std::span<const std::byte>> fields);
+    void AppendBytes(std::span<const std::byte> bytes);
+    void Pad(size_t alignment);
+
+    FILE* m_file;
+    std::vector<std::byte> m_block;
+    std::vector<uint32_t> m_recordOffsets;
+};
+
+// A typed view of one record, pointing into a mapped block.
+template <typename Fixed, size_t FieldCount>
+class SpillRecordView
+{
+public:
+    static_assert(std::is_trivially_copyable_v<Fixed>);
+
+    explicit SpillRecordView(std::span<const std::byte> record)
+        : m_record(record)
+    {
+        WI_ASSERT(reinterpret_cast<uintptr_t>(record.data()) % c_spillRecordAlignment == 0);
+        WI_ASSERT(record.size() >= c_tableOffset + (FieldCount + 1) * sizeof(uint32_t));
+    }
+
+    const Fixed& GetFixed() const
+    {
+        return *reinterpret_cast<const Fixed*>(m_record.data());
+    }
+
+    std::span<const std::byte> GetField(size_t index) const
+    {
+        WI_ASSERT(index < FieldCount);
+
+        const uint32_t begin = FieldOffset(index);
+        const uint32_t end = FieldOffset(index + 1);
+        WI_ASSERT(begin <= end && end <= m_record.size());
+        return m_record.subspan(begin, end - begin);
+    }
+
+    std::string_view GetFieldAsString(size_t index) const
+    {
+        std::span<const std::byte> field = GetField(index);
+        return { reinterpret_cast<const char*>(field.data()), field.size() };
+    }
+
+private:
+    static constexpr size_t c_tableOffset = (sizeof(Fixed) + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+
+    uint32_t FieldOffset(size_t index) const
+    {
+        return reinterpret_cast<const uint32_t*>(m_record.data() + c_tableOffset)[index];
+    }
+
+    std::span<const std::byte> m_record;
+};
+
+// A view of one block in a mapped temp file.
+class SpillBlockView
+{
+public:
+    // Checks the block's header, and that it fits within bytes.
+    explicit SpillBlockView(std::span<const std::byte> bytes);
+
+    // Whether bytes starts with a block that the constructor would accept.
+    static bool IsValid(std::span<const std::byte> bytes);
+
+    uint32_t RecordCount() const { return Header().recordCount; }
+
+    // Size of the block, including padding. The next block, if any, starts
+    // this many bytes after this one.
+    uint32_t Size() const { return Header().blockSize; }
+
+    std::span<const std::byte> GetRecord(uint32_t index) const;
+
+    template <typename Fixed, size_t FieldCount>
+    SpillRecordView<Fixed, FieldCount> GetRecordAs(uint32_t index) const
+    {
+        return SpillRecordView<Fixed, FieldCount>{ GetRecord(index) };
+    }
+
+private:
+    const SpillBlockHeader& Header() const
+    {
+        return *reinterpret_cast<const SpillBlockHeader*>(m_block.data());
+    }
+
+    std::span<const std::byte> m_block;
+};
+
+// A read-only mapping of the current contents of a temp file.
+class MappedSpillFile
+{
+public:
+    // Flushes file and maps everything that has been written to it.
+    explicit MappedSpillFile(FILE* file);
+
+    std::span<const std::byte> GetBytes() const { return { m_view.get(), m_size }; }
+
+    SpillBlockView GetBlockAt(uint64_t offset) const;
+
+private:
+    wil::unique_handle m_mapping;
+    wil::unique_mapview_ptr<std::byte> m_view;
+    size_t m_size = 0;
+};
@@ -0,0 +1,514 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SpillableBitmap.h"
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <bit>
+#include <emmintrin.h>
+#include <iterator>
+
+size_t SpillableBitmap::Container::Bytes() const
+{
+    return bits.capacity() * sizeof(uint64_t) + array.capacity() * sizeof(uint16_t);
+}
+
+size_t SpillableBitmap::Container::DataBytes() const
+{
+    return IsBitmap() ? bits.size() * sizeof(uint64_t) : array.size() * sizeof(uint16_t);
+}
+
+bool SpillableBitmap::Container::Contains(uint16_t low) const
+{
+    if (IsBitmap())
+    {
+        return (bits[low / 64] >> (low % 64)) & 1;
+    }
+
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void SpillableBitmap::Container::Add(uint16_t low)
+{
+    if (IsBitmap())
+    {
+        const uint64_t bit = uint64_t{ 1 } << (low % 64);
+        cardinality += (bits[low / 64] & bit) == 0;
+        bits[low / 64] |= bit;
+        return;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low)
+    {
+        return;
+    }
+
+    array.insert(it, low);
+    ++cardinality;
+    if (array.size() > c_maxArraySize)
+    {
+        ConvertToBitmap();
+    }
+}
+
+void SpillableBitmap::Container::IntersectWith(const Container& other)
+{
+    if (IsBitmap() && other.IsBitmap())
+    {
+        uint32_t count = 0;
+        for (size_t i = 0; i < c_bitmapWords; i += 2)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bits[i]));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.bits[i]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&bits[i]), _mm_and_si128(a, b));
+            count += std::popcount(bits[i]) + std::popcount(bits[i + 1]);
+        }
+
+        cardinality = count;
+        if (cardinality <= c_maxArraySize)
+        {
+            // Convert back to an array.
+            std::vector<uint16_t> values;
+            values.reserve(cardinality);
+            for (uint32_t low = 0; low < 65536; ++low)
+            {
+                if ((bits[low / 64] >> (low % 64)) & 1)
+                {
+                    values.push_back(static_cast<uint16_t>(low));
+                }
+            }
+
+            array = std::move(values);
+            bits = {};
+        }
+
+        return;
+    }
+
+    // At least one side is an array, so the result is small enough to be
+    // an array.
+    std::vector<uint16_t> result;
+    if (IsBitmap())
+    {
+        std::copy_if(other.array.begin(), other.array.end(), std::back_inserter(result), [&](uint16_t low) { return Contains(low); });
+    }
+    else if (other.IsBitmap())
+    {
+        std::copy_if(array.begin(), array.end(), std::back_inserter(result), [&](uint16_t low) { return other.Contains(low); });
+    }
+    else
+    {
+        std::set_intersection(array.begin(), array.end(), other.array.begin(), other.array.end(), std::back_inserter(result));
+    }
+
+    array = std::move(result);
+    bits = {};
+    cardinality = static_cast<uint32_t>(array.size());
+}
+
+void SpillableBitmap::Container::UnionWith(const Container& other)
+{
+    if (!IsBitmap() && !other.IsBitmap())
+    {
+        std::vector<uint16_t> result;
+        result.reserve(array.size() + other.array.size());
+        std::set_union(array.begin(), array.end(), other.array.begin(), other.array.end(), std::back_inserter(result));
+        array = std::move(result);
+        cardinality = static_cast<uint32_t>(array.size());
+        if (array.size() > c_maxArraySize)
+        {
+            ConvertToBitmap();
+        }
+
+        return;
+    }
+
+    if (!IsBitmap())
+    {
+        ConvertToBitmap();
+    }
+
+    if (other.IsBitmap())
+    {
+        uint32_t count = 0;
+        for (size_t i = 0; i < c_bitmapWords; i += 2)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bits[i]));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.bits[i]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&bits[i]), _mm_or_si128(a, b));
+            count += std::popcount(bits[i]) + std::popcount(bits[i + 1]);
+        }
+
+        cardinality = count;
+    }
+    else
+    {
+        for (uint16_t low : other.array)
+        {
+            Add(low);
+        }
+    }
+}
+
+void SpillableBitmap::Container::ConvertToBitmap()
+{
+    bits.assign(c_bitmapWords, 0);
+    for (uint16_t low : array)
+    {
+        bits[low / 64] |= uint64_t{ 1 } << (low % 64);
+    }
+
+    array = {};
+}
+
+SpillableBitmap::SpillableBitmap(size_t memoryBudgetBytes)
+    : m_memoryBudgetBytes(memoryBudgetBytes)
+{
+}
+
+void SpillableBitmap::Add(uint32_t value)
+{
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    Container* container = GetContainer(key, true);
+
+    const size_t oldBytes = container->Bytes();
+    const uint32_t oldCardinality = container->cardinality;
+    container->Add(static_cast<uint16_t>(value));
+    if (container->cardinality != oldCardinality)
+    {
+        m_slots[key].dirty = true;
+        OnContainerChanged(key, oldBytes);
+    }
+}
+
+bool SpillableBitmap::Contains(uint32_t value)
+{
+    Container* container = GetContainer(static_cast<uint16_t>(value >> 16), false);
+    return container != nullptr && container->Contains(static_cast<uint16_t>(value));
+}
+
+uint64_t SpillableBitmap::Cardinality() const
+{
+    uint64_t cardinality = 0;
+    for (const auto& [key, slot] : m_slots)
+    {
+        cardinality += slot.container ? slot.container->cardinality : slot.spilled->cardinality;
+    }
+
+    return cardinality;
+}
+
+void SpillableBitmap::IntersectWith(SpillableBitmap& other)
+{
+    for (auto it = m_slots.begin(); it != m_slots.end();)
+    {
+        const uint16_t key = it->first;
+        const Container* otherContainer = other.GetContainer(key, false);
+        if (otherContainer == nullptr)
+        {
+            Remove(it++);
+            continue;
+        }
+
+        Container* container = GetContainer(key, false);
+        const size_t oldBytes = container->Bytes();
+        container->IntersectWith(*otherContainer);
+        if (container->cardinality == 0)
+        {
+            m_memoryBytes = m_memoryBytes - oldBytes + container->Bytes();
+            Remove(it++);
+            continue;
+        }
+
+        it->second.dirty = true;
+        OnContainerChanged(key, oldBytes);
+        ++it;
+    }
+}
+
+void SpillableBitmap::UnionWith(SpillableBitmap& other)
+{
+    // Collect the keys first, since getting other's containers may change
+    // which ones it has in memory.
+    std::vector<uint16_t> keys;
+    keys.reserve(other.m_slots.size());
+    for (const auto& [key, slot] : other.m_slots)
+    {
+        keys.push_back(key);
+    }
+
+    for (uint16_t key : keys)
+    {
+        const Container* otherContainer = other.GetContainer(key, false);
+        Container* container = GetContainer(key, true);
+        const size_t oldBytes = container->Bytes();
+        container->UnionWith(*otherContainer);
+        m_slots[key].dirty = true;
+        OnContainerChanged(key, oldBytes);
+    }
+}
+
+void SpillableBitmap::ForEach(const std::function<void(uint32_t value)>& onValue)
+{
+    std::vector<uint16_t> keys;
+    keys.reserve(m_slots.size());
+    for (const auto& [key, slot] : m_slots)
+    {
+        keys.push_back(key);
+    }
+
+    for (uint16_t key : keys)
+    {
+        const Container* container = GetContainer(key, false);
+        const uint32_t high = uint32_t{ key } << 16;
+        if (container->IsBitmap())
+        {
+            for (size_t i = 0; i < c_bitmapWords; ++i)
+            {
+                for (uint64_t word = container->bits[i]; word != 0; word &= word - 1)
+                {
+                    onValue(high | static_cast<uint32_t>(i * 64 + std::countr_zero(word)));
+                }
+            }
+        }
+        else
+        {
+            for (uint16_t low : container->array)
+            {
+                onValue(high | low);
+            }
+        }
+    }
+}
+
+SpillableBitmap::Container* SpillableBitmap::GetContainer(uint16_t key, bool create)
+{
+    auto it = m_slots.find(key);
+    if (it == m_slots.end())
+    {
+        if (!create)
+        {
+            return nullptr;
+        }
+
+        it = m_slots.emplace(key, Slot{ .container = std::make_unique<Container>() }).first;
+    }
+
+    Slot& slot = it->second;
+    if (slot.container)
+    {
+        MarkUsed(slot);
+    }
+    else
+    {
+        // Read it back in. It is unchanged from what's on disk, so it can
+        // be spilled again later without writing it.
+        auto container = std::make_unique<Container>();
+        container->cardinality = slot.spilled->cardinality;
+        if (slot.spilled->isBitmap)
+        {
+            container->bits.resize(c_bitmapWords);
+        }
+        else
+        {
+            container->array.resize(slot.spilled->cardinality);
+        }
+
+        void* data = container->IsBitmap() ? static_cast<void*>(container->bits.data()) : container->array.data();
+        const size_t bytes = container->DataBytes();
+        THROW_HR_IF(ErrnoToHresult(errno), _fseeki64(m_file.get(), static_cast<int64_t>(slot.spilled->offset), SEEK_SET) != 0);
+        THROW_HR_IF(ErrnoToHresult(errno), fread(data, 1, bytes, m_file.get()) != bytes);
+
+        slot.container = std::move(container);
+        slot.dirty = false;
+        MarkUsed(slot);
+        m_memoryBytes += slot.container->Bytes();
+        EnforceBudget(slot);
+    }
+
+    return slot.container.get();
+}
+
+void SpillableBitmap::OnContainerChanged(uint16_t key, size_t oldBytes)
+{
+    const Slot& slot = m_slots[key];
+    m_memoryBytes = m_memoryBytes - oldBytes + slot.container->Bytes();
+    EnforceBudget(slot);
+}
+
+void SpillableBitmap::EnforceBudget(const Slot& keep)
+{
+    while (m_memoryBytes > m_memoryBudgetBytes)
+    {
+        // keep was just used, so it can only be the least recently used
+        // container if it's the only one in memory.
+        Slot* coldest = m_leastRecentlyUsed;
+        if (coldest == &keep)
+        {
+            coldest = coldest->newerInMemory;
+        }
+
+        if (coldest == nullptr)
+        {
+            return;
+        }
+
+        Spill(*coldest);
+    }
+}
+
+void SpillableBitmap::Spill(Slot& slot)
+{
+    const Container& container = *slot.container;
+
+    if (slot.dirty || !slot.spilled)
+    {
+        if (!m_file)
+        {
+            m_file.reset(CreateTmpFileWithPosixDelete(true).file);
+        }
+
+        // Overwrite the previous copy if this fits in its space, and
+        // otherwise take the smallest free space that fits, if any. Bitmap
+        // containers are all the same size, so they always fit. Space is
+        // set aside in powers of two, so that growing array containers
+        // have room to grow, and space they give up fits others.
+        const size_t bytes = container.DataBytes();
+        const std::optional<SpillLocation> previous = slot.spilled;
+        auto freeSpace = m_freeSpace.end();
+        uint64_t offset = m_fileSize;
+        uint32_t reservedBytes = std::bit_ceil(static_cast<uint32_t>(bytes));
+        if (previous && previous->reservedBytes >= bytes)
+        {
+            offset = previous->offset;
+            reservedBytes = previous->reservedBytes;
+        }
+        else
+        {
+            freeSpace = m_freeSpace.lower_bound(reservedBytes);
+            if (freeSpace != m_freeSpace.end())
+            {
+                offset = freeSpace->second;
+                reservedBytes = freeSpace->first;
+            }
+        }
+
+        const void* data = container.IsBitmap() ? static_cast<const void*>(container.bits.data()) : container.array.data();
+        THROW_HR_IF(ErrnoToHresult(errno), _fseeki64(m_file.get(), static_cast<int64_t>(offset), SEEK_SET) != 0);
+        THROW_HR_IF(ErrnoToHresult(errno), fwrite(data, 1, bytes, m_file.get()) != bytes);
+
+        // Only update the bookkeeping once the write has succeeded.
+        if (offset == m_fileSize)
+        {
+            m_fileSize += reservedBytes;
+        }
+
+        if (freeSpace != m_freeSpace.end())
+        {
+            m_freeSpace.erase(freeSpace);
+        }
+
+        if (previous && previous->offset != offset)
+        {
+            m_freeSpace.emplace(previous->reservedBytes, previous->offset);
+        }
+
+        slot.spilled = SpillLocation{
+            .offset = offset,
+            .reservedBytes = reservedBytes,
+            .cardinality = container.cardinality,
+            .isBitmap = container.IsBitmap(),
+        };
+    }
+
+    UnlinkFromMemory(slot);
+    m_memoryBytes -= container.Bytes();
+    slot.container.reset();
+    slot.dirty = false;
+}
+
+void SpillableBitmap::Remove(std::map<uint16_t, Slot>::iterator it)
+{
+    Slot& slot = it->second;
+    if (slot.container)
+    {
+        UnlinkFromMemory(slot);
+        m_memoryBytes -= slot.container->Bytes();
+    }
+
+    if (slot.spilled)
+    {
+        m_freeSpace.emplace(slot.spilled->reservedBytes, slot.spilled->offset);
+    }
+
+    m_slots.erase(it);
+}
+
+void SpillableBitmap::MarkUsed(Slot& slot)
+{
+    if (m_mostRecentlyUsed == &slot)
+    {
+        return;
+    }
+
+    UnlinkFromMemory(slot);
+    slot.olderInMemory = m_mostRecentlyUsed;
+    if (m_mostRecentlyUsed != nullptr)
+    {
+        m_mostRecentlyUsed->newerInMemory = &slot;
+    }
+    else
+    {
+        m_leastRecentlyUsed = &slot;
+    }
+
+    m_mostRecentlyUsed = &slot;
+}
+
+void SpillableBitmap::UnlinkFromMemory(Slot& slot)
+{
+    if (slot.olderInMemory != nullptr)
+    {
+        slot.olderInMemory->newerInMemory = slot.newerInMemory;
+    }
+    else if (m_leastRecentlyUsed == &slot)
+    {
+        m_leastRecentlyUsed = slot.newerInMemory;
+    }
+
+    if (slot.newerInMemory != nullptr)
+    {
+        slot.newerInMemory->olderInMemory = slot.olderInMemory;
+    }
+    else if (m_mostRecentlyUsed == &slot)
+    {
+        m_mostRecentlyUsed = slot.olderInMemory;
+    }
+
+    slot.olderInMemory = nullptr;
+    slot.newerInMemory = nullptr;
+}
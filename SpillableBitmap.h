@@ -0,0 +1,166 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+// Must come before wil/resource.h for wil::unique_file.
+#include <stdio.h>
+
+#include <wil/resource.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// A compressed bitmap of uint32_t row IDs for semi-joins and anti-joins
+// too big to keep in memory, even compressed.
+//
+// Like a roaring bitmap, row IDs are split by their high 16 bits into
+// containers, each holding the low 16 bits of its row IDs either as a
+// sorted array, when there are at most c_maxArraySize of them, or as a
+// 65536-bit bitmap. Bitmap containers are intersected and unioned 128 bits
+// at a time with SSE2.
+//
+// When the containers take up more than the memory budget, the least
+// recently used ones are written out to a POSIX-deleted temp file and
+// freed. They are read back in the next time they're needed. A container
+// that is spilled again overwrites its previous copy if it still fits
+// there, and space that is given up is reused for other containers, so the
+// file only grows with the containers' total size.
+class SpillableBitmap
+{
+public:
+    static constexpr size_t c_maxArraySize = 4096;
+
+    explicit SpillableBitmap(size_t memoryBudgetBytes);
+
+    SpillableBitmap(const SpillableBitmap&) = delete;
+    SpillableBitmap& operator=(const SpillableBitmap&) = delete;
+
+    void Add(uint32_t value);
+    bool Contains(uint32_t value);
+    uint64_t Cardinality() const;
+
+    // Removes every value that isn't also in other.
+    void IntersectWith(SpillableBitmap& other);
+
+    // Adds every value in other.
+    void UnionWith(SpillableBitmap& other);
+
+    // Calls onValue for every value, in order.
+    void ForEach(const std::function<void(uint32_t value)>& onValue);
+
+    // Bytes of containers currently in memory.
+    size_t MemoryBytes() const { return m_memoryBytes; }
+
+private:
+    struct Container
+    {
+        // Used while the container has at most c_maxArraySize values.
+        std::vector<uint16_t> array;
+
+        // c_bitmapWords words once the container has more values than that.
+        std::vector<uint64_t> bits;
+
+        uint32_t cardinality = 0;
+
+        bool IsBitmap() const { return !bits.empty(); }
+
+        // Bytes allocated for the values.
+        size_t Bytes() const;
+
+        // Bytes of values, as written to the file.
+        size_t DataBytes() const;
+
+        bool Contains(uint16_t low) const;
+        void Add(uint16_t low);
+        void IntersectWith(const Container& other);
+        void UnionWith(const Container& other);
+        void ConvertToBitmap();
+    };
+
+    struct SpillLocation
+    {
+        uint64_t offset;
+
+        // The space set aside at offset, which may be more than the
+        // container needs.
+        uint32_t reservedBytes;
+
+        uint32_t cardinality;
+        bool isBitmap;
+    };
+
+    struct Slot
+    {
+        // nullptr while the container is only on disk.
+        std::unique_ptr<Container> container;
+
+        // Where the container was last written, if anywhere.
+        std::optional<SpillLocation> spilled;
+
+        // Whether the container has changed since it was last written.
+        bool dirty = true;
+
+        // Neighbors in the list of containers in memory, from least to
+        // most recently used.
+        Slot* olderInMemory = nullptr;
+        Slot* newerInMemory = nullptr;
+    };
+
+    static constexpr size_t c_bitmapWords = 65536 / 64;
+
+    // Gets the container for key, reading it back in if it was spilled.
+    // Returns nullptr if there's no container for key and create is false.
+    Container* GetContainer(uint16_t key, bool create);
+
+    // Updates the memory accounting after the container at key changed
+    // size from oldBytes, and spills other containers if over budget.
+    void OnContainerChanged(uint16_t key, size_t oldBytes);
+
+    // Spills the least recently used containers, other than keep, until
+    // back under budget.
+    void EnforceBudget(const Slot& keep);
+
+    void Spill(Slot& slot);
+    void Remove(std::map<uint16_t, Slot>::iterator it);
+
+    // Moves an in-memory slot to the most recently used end of the list.
+    void MarkUsed(Slot& slot);
+    void UnlinkFromMemory(Slot& slot);
+
+    size_t m_memoryBudgetBytes;
+    size_t m_memoryBytes = 0;
+    std::map<uint16_t, Slot> m_slots;
+    Slot* m_leastRecentlyUsed = nullptr;
+    Slot* m_mostRecentlyUsed = nullptr;
+
+    wil::unique_file m_file;
+    uint64_t m_fileSize = 0;
+
+    // Offsets of unused space in the file, by its size.
+    std::multimap<uint32_t, uint64_t> m_freeSpace;
+};
@@ -0,0 +1,125 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TmpFile.h"
+
+#include "NtSetInformationFile.h"
+
+#include <windows.h>
+
+#include <wil/filesystem.h>
+#include <wil/resource.h>
+#include <wil/result.h>
+#include <winerror.h>
+
+#include <io.h>
+#include <string>
+#include <stdio.h>
+
+TmpFile CreateTmpFileWithPosixDelete(bool shouldPosixDelete)
+{
+    // Create a temporary file. Ownership of this FILE* passes to the
+    // caller, which may intentionally leak it so that its HANDLE is still
+    // open when the system is crashed.
+    FILE* tmpFile;
+    errno_t err = tmpfile_s(&tmpFile);
+    THROW_HR_IF(ErrnoToHresult(err), err != 0);
+    THROW_HR_IF_NULL(E_UNEXPECTED, tmpFile);
+
+    // Get the OS HANDLE for the temporary file
+    HANDLE tempFileHandle = GetTmpFileHandle(tmpFile);
+
+    std::wstring originalPath = GetFilePath(tempFileHandle);
+
+    // If the system crashes before we issue a POSIX delete, then an empty
+    // file will be left around. This is a very small window, however.
+    if (shouldPosixDelete)
+    {
+        // To successfully perform a POSIX delete on the file, we need to
+        // set FILE_DISPOSITION_DELETE | FILE_DISPOSITION_POSIX_SEMANTICS on
+        // the NT "file object" and then close all handles to the file
+        // object.
+        //
+        // Use ReOpenFile to get another file object for the temp file.
+        // Using tempFileHandle or DuplicateHandle(..., tempFileHandle, ...)
+        // will not work, since that will set the flags on the file object
+        // that the FILE*'s HANDLE refers to. Since FILE* has an open
+        // handle, that file object will never be closed, so the deletion
+        // won't occur until after the FILE* is closed. But we want the
+        // deletion to occur so that if we can't close the FILE* and the
+        // system crashes, the file will have already been deleted, and it
+        // will be cleaned up on the next boot.
+        wil::unique_hfile reopened{ ReOpenFile(tempFileHandle, DELETE, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, 0) };
+        THROW_LAST_ERROR_IF(!reopened.is_valid());
+
+        // Delete the file with POSIX semantics
+        FILE_DISPOSITION_INFORMATION_EX disp{ .Flags = FILE_DISPOSITION_DELETE | FILE_DISPOSITION_POSIX_SEMANTICS };
+        IO_STATUS_BLOCK ioStatusBlock;
+        THROW_IF_NTSTATUS_FAILED(
+            NtSetInformationFile(
+                reopened.get(),
+                &ioStatusBlock,
+                &disp,
+                sizeof(disp),
+                FileDispositionInformationEx));
+
+        // Close the handle to the second file object so that the POSIX
+        // deletion is performed.
+        reopened.reset();
+
+        return TmpFile
+        {
+            .file = tmpFile,
+            .handle = tempFileHandle,
+            .paths =
+            {
+                .original = originalPath,
+                .current = GetFilePath(tempFileHandle),
+            },
+        };
+    }
+    else
+    {
+        return TmpFile{
+            .file = tmpFile,
+            .handle = tempFileHandle,
+            .paths =
+            {
+                .original = originalPath,
+                .current = originalPath,
+            },
+        };
+    }
+}
+
+HANDLE GetTmpFileHandle(FILE* file)
+{
+    int fd = _fileno(file);
+    THROW_HR_IF(ErrnoToHresult(errno), fd == -1);
+    HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    THROW_HR_IF(ErrnoToHresult(errno), h == INVALID_HANDLE_VALUE);
+    return h;
+}
+
+std::wstring GetFilePath(HANDLE h)
+{
+    wil::unique_cotaskmem_string path = wil::GetFinalPathNameByHandleW(h);
+    return { path.get() };
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <string>
+#include <stdio.h>
+
+struct TmpFilePaths
+{
+    std::wstring original;
+    std::wstring current;
+};
+
+struct TmpFile
+{
+    // The FILE* returned by tmpfile_s. Closing it deletes the file.
+    FILE* file;
+
+    // The OS HANDLE underlying file. It is owned by file, so don't close it.
+    HANDLE handle;
+
+    TmpFilePaths paths;
+};
+
+// Creates a temporary file with tmpfile_s and, if shouldPosixDelete is
+// set, POSIX deletes it right away so that it is cleaned up even if the
+// system crashes while it is still open.
+TmpFile CreateTmpFileWithPosixDelete(bool shouldPosixDelete);
+
+// Gets the OS HANDLE underlying a FILE*. The HANDLE is owned by the FILE*.
+HANDLE GetTmpFileHandle(FILE* file);
+
+std::wstring GetFilePath(HANDLE h);
+
+constexpr HRESULT ErrnoToHresult(errno_t err)
+{
+    // A random HRESULT facility with the "customer" flag set, since there
+    // isn't a facility for the MSVC CRT.
+    const uint16_t FACILITY_CUSTOMER_CRT = (0b1 << 16) | 0x1898;
+    return MAKE_HRESULT(1, FACILITY_CUSTOMER_CRT, static_cast<uint16_t>(err));
+}
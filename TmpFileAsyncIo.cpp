@@ -0,0 +1,232 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TmpFileAsyncIo.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <utility>
+
+TmpFileAsyncIo::TmpFileAsyncIo(HANDLE tmpFileHandle, const Options& options)
+    : m_mode(options.mode)
+{
+    THROW_HR_IF(E_INVALIDARG, options.pollCpu && *options.pollCpu >= sizeof(KAFFINITY) * 8);
+
+    m_file.reset(ReOpenFile(
+        tmpFileHandle,
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE,
+        FILE_FLAG_OVERLAPPED | (options.unbuffered ? FILE_FLAG_NO_BUFFERING : 0)));
+    THROW_LAST_ERROR_IF(!m_file.is_valid());
+
+    // Operations that complete right away are finished by the submitter,
+    // so they shouldn't be queued to the port too.
+    THROW_IF_WIN32_BOOL_FALSE(SetFileCompletionNotificationModes(m_file.get(), FILE_SKIP_COMPLETION_PORT_ON_SUCCESS));
+
+    if (m_mode == CompletionMode::Interrupt)
+    {
+        m_port.reset(CreateIoCompletionPort(m_file.get(), nullptr, 0, 1));
+        THROW_LAST_ERROR_IF_NULL(m_port.get());
+
+        m_completionThread = std::thread{ [this]() { RunInterruptCompletions(); } };
+    }
+    else
+    {
+        m_completionThread = std::thread{ [this, pollCpu = options.pollCpu]() { RunBusyPollCompletions(pollCpu); } };
+    }
+}
+
+TmpFileAsyncIo::~TmpFileAsyncIo()
+{
+    for (size_t inFlight = m_inFlight.load(); inFlight != 0; inFlight = m_inFlight.load())
+    {
+        m_inFlight.wait(inFlight);
+    }
+
+    if (m_mode == CompletionMode::Interrupt)
+    {
+        // A completion without an OVERLAPPED tells the thread to stop.
+        LOG_IF_WIN32_BOOL_FALSE(PostQueuedCompletionStatus(m_port.get(), 0, 0, nullptr));
+    }
+    else
+    {
+        m_stopping = true;
+    }
+
+    m_completionThread.join();
+}
+
+void TmpFileAsyncIo::ReadAsync(uint64_t offset, std::span<std::byte> buffer, CompletionCallback onComplete)
+{
+    THROW_HR_IF(E_INVALIDARG, buffer.size() > MAXDWORD);
+    Submit(offset, std::move(onComplete), [&](OVERLAPPED* overlapped)
+        {
+            return ReadFile(m_file.get(), buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, overlapped);
+        });
+}
+
+void TmpFileAsyncIo::WriteAsync(uint64_t offset, std::span<const std::byte> data, CompletionCallback onComplete)
+{
+    THROW_HR_IF(E_INVALIDARG, data.size() > MAXDWORD);
+    Submit(offset, std::move(onComplete), [&](OVERLAPPED* overlapped)
+        {
+            return WriteFile(m_file.get(), data.data(), static_cast<DWORD>(data.size()), nullptr, overlapped);
+        });
+}
+
+template <typename Start>
+void TmpFileAsyncIo::Submit(uint64_t offset, CompletionCallback onComplete, Start&& start)
+{
+    auto operation = std::make_unique<Operation>();
+    operation->overlapped.Offset = static_cast<DWORD>(offset);
+    operation->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    operation->onComplete = std::move(onComplete);
+
+    // Make room for the operation before starting it. Once the I/O is
+    // pending, nothing can be allowed to fail before the polling thread
+    // knows about it.
+    if (m_mode == CompletionMode::BusyPoll)
+    {
+        auto lock = m_submittedLock.lock_exclusive();
+        m_submitted.reserve(m_submitted.size() + m_reservedSlots + 1);
+        ++m_reservedSlots;
+    }
+
+    ++m_inFlight;
+
+    // Once the I/O is started, the completion thread may finish it at any
+    // time, so it can't be owned here any more.
+    Operation* started = operation.release();
+    const DWORD error = start(&started->overlapped) ? ERROR_SUCCESS : GetLastError();
+    if (m_mode == CompletionMode::BusyPoll)
+    {
+        auto lock = m_submittedLock.lock_exclusive();
+        --m_reservedSlots;
+        if (error == ERROR_IO_PENDING)
+        {
+            m_submitted.emplace_back(started);
+        }
+    }
+
+    if (error == ERROR_IO_PENDING)
+    {
+        return;
+    }
+
+    // It completed, or failed, right away.
+    if (error != ERROR_SUCCESS)
+    {
+        Finish(std::unique_ptr<Operation>{ started }, HRESULT_FROM_WIN32(error), 0);
+    }
+    else
+    {
+        Complete(std::unique_ptr<Operation>{ started });
+    }
+}
+
+void TmpFileAsyncIo::RunInterruptCompletions()
+{
+    for (;;)
+    {
+        OVERLAPPED_ENTRY entries[64];
+        ULONG removed = 0;
+        if (!GetQueuedCompletionStatusEx(m_port.get(), entries, ARRAYSIZE(entries), &removed, INFINITE, FALSE))
+        {
+            LOG_LAST_ERROR();
+            continue;
+        }
+
+        for (ULONG i = 0; i < removed; ++i)
+        {
+            if (entries[i].lpOverlapped == nullptr)
+            {
+                return;
+            }
+
+            Complete(std::unique_ptr<Operation>{ CONTAINING_RECORD(entries[i].lpOverlapped, Operation, overlapped) });
+        }
+    }
+}
+
+void TmpFileAsyncIo::RunBusyPollCompletions(std::optional<DWORD> pollCpu)
+{
+    if (pollCpu)
+    {
+        LOG_LAST_ERROR_IF(SetThreadAffinityMask(GetCurrentThread(), KAFFINITY{ 1 } << *pollCpu) == 0);
+    }
+
+    std::vector<std::unique_ptr<Operation>> inFlight;
+    while (!m_stopping.load(std::memory_order_relaxed))
+    {
+        {
+            auto lock = m_submittedLock.lock_exclusive();
+            for (std::unique_ptr<Operation>& operation : m_submitted)
+            {
+                inFlight.push_back(std::move(operation));
+            }
+
+            m_submitted.clear();
+        }
+
+        for (size_t i = 0; i < inFlight.size();)
+        {
+            // This only reads the OVERLAPPED's status, which the kernel
+            // sets when the I/O completes. No syscall.
+            if (!HasOverlappedIoCompleted(&inFlight[i]->overlapped))
+            {
+                ++i;
+                continue;
+            }
+
+            std::unique_ptr<Operation> operation = std::move(inFlight[i]);
+            inFlight[i] = std::move(inFlight.back());
+            inFlight.pop_back();
+            Complete(std::move(operation));
+        }
+
+        YieldProcessor();
+    }
+}
+
+void TmpFileAsyncIo::Complete(std::unique_ptr<Operation> operation)
+{
+    DWORD bytesTransferred = 0;
+    const HRESULT hr = GetOverlappedResult(m_file.get(), &operation->overlapped, &bytesTransferred, FALSE)
+        ? S_OK
+        : HRESULT_FROM_WIN32(GetLastError());
+
+    Finish(std::move(operation), hr, bytesTransferred);
+}
+
+void TmpFileAsyncIo::Finish(std::unique_ptr<Operation> operation, HRESULT hr, DWORD bytesTransferred)
+{
+    try
+    {
+        operation->onComplete(hr, bytesTransferred);
+    }
+    CATCH_LOG()
+
+    operation.reset();
+
+    --m_inFlight;
+    m_inFlight.notify_all();
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+#include <wil/resource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Asynchronous, positional reads and writes of a temp file.
+//
+// The temp file's own HANDLE is synchronous, so this opens a second,
+// overlapped file object for it with ReOpenFile, the same way
+// CreateTmpFileWithPosixDelete gets the file object it deletes through.
+//
+// Completions are handled on a dedicated thread in one of two ways:
+//
+// * Interrupt: the thread blocks on an I/O completion port. This costs
+//   nothing while idle, but each completion has to wake the thread up.
+// * BusyPoll: the thread spins checking whether in-flight operations'
+//   OVERLAPPEDs have completed, without making any syscalls, optionally
+//   pinned to one CPU. This uses up that CPU, but picks up completions
+//   as soon as they happen.
+//
+// Windows has no equivalent of io_uring's SQPOLL, so submission is always
+// a syscall on the submitting thread. Operations that complete right away,
+// which is common for cached I/O, call onComplete on the submitting thread
+// before returning.
+class TmpFileAsyncIo
+{
+public:
+    enum class CompletionMode
+    {
+        Interrupt,
+        BusyPoll,
+    };
+
+    struct Options
+    {
+        CompletionMode mode = CompletionMode::Interrupt;
+
+        // For BusyPoll, the CPU to pin the polling thread to.
+        std::optional<DWORD> pollCpu;
+
+        // Bypass the file system cache. Offsets, sizes, and buffer
+        // addresses must then all be multiples of the volume's sector size.
+        bool unbuffered = false;
+    };
+
+    using CompletionCallback = std::function<void(HRESULT hr, DWORD bytesTransferred)>;
+
+    TmpFileAsyncIo(HANDLE tmpFileHandle, const Options& options);
+
+    // Waits for in-flight operations to complete, then stops the
+    // completion thread.
+    ~TmpFileAsyncIo();
+
+    TmpFileAsyncIo(const TmpFileAsyncIo&) = delete;
+    TmpFileAsyncIo& operator=(const TmpFileAsyncIo&) = delete;
+
+    // buffer must stay valid until onComplete is called, and be at most
+    // MAXDWORD bytes.
+    void ReadAsync(uint64_t offset, std::span<std::byte> buffer, CompletionCallback onComplete);
+
+    // data must stay valid until onComplete is called, and be at most
+    // MAXDWORD bytes.
+    void WriteAsync(uint64_t offset, std::span<const std::byte> data, CompletionCallback onComplete);
+
+private:
+    struct Operation
+    {
+        OVERLAPPED overlapped;
+
+        CompletionCallback onComplete;
+    };
+
+    template <typename Start>
+    void Submit(uint64_t offset, CompletionCallback onComplete, Start&& start);
+
+    void RunInterruptCompletions();
+    void RunBusyPollCompletions(std::optional<DWORD> pollCpu);
+    // Gets the result of a finished operation and calls its callback.
+    void Complete(std::unique_ptr<Operation> operation);
+    void Finish(std::unique_ptr<Operation> operation, HRESULT hr, DWORD bytesTransferred);
+
+    wil::unique_hfile m_file;
+    CompletionMode m_mode;
+    wil::unique_handle m_port;
+
+    // Operations waiting to be picked up by the busy-polling thread.
+    // m_submitted always has room for m_reservedSlots more, so that adding
+    // an operation once its I/O has started can't fail.
+    wil::srwlock m_submittedLock;
+    std::vector<std::unique_ptr<Operation>> m_submitted;
+    size_t m_reservedSlots = 0;
+
+    std::atomic<size_t> m_inFlight{ 0 };
+    std::atomic<bool> m_stopping{ false };
+    std::thread m_completionThread;
+};
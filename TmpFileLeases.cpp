@@ -0,0 +1,207 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TmpFileLeases.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+namespace
+{
+    void CloseLeasedFile(details::TmpFileLeaseState& state)
+    {
+        LOG_HR_IF(ErrnoToHresult(errno), fclose(state.file) != 0);
+        state.file = nullptr;
+    }
+
+    void ReclaimIfUnused(details::TmpFileLeaseState& state)
+    {
+        // Leave the file alone if it's in use right now. Using it renews
+        // the lease anyway.
+        auto stateLock = state.lock.try_lock_exclusive();
+        if (!stateLock || state.file == nullptr)
+        {
+            return;
+        }
+
+        // The lease was dropped properly; its file just wasn't free to
+        // close at the time.
+        if (state.released)
+        {
+            CloseLeasedFile(state);
+            return;
+        }
+
+        // The lease may have been used, and so renewed, since Reap saw it
+        // had expired.
+        if (state.expiresAtMs > GetTickCount64())
+        {
+            return;
+        }
+
+        // Truncate first so the disk space is freed even if something else,
+        // like a duplicated handle, still has the file open. Flush before
+        // truncating so that closing doesn't write the buffered data back
+        // out. Files with mapped views can't be truncated; their space is
+        // only freed once the last view is unmapped.
+        const HANDLE h = GetTmpFileHandle(state.file);
+        LOG_HR_IF(ErrnoToHresult(errno), fflush(state.file) != 0);
+        FILE_END_OF_FILE_INFO endOfFile{};
+        const bool truncated = SetFileInformationByHandle(h, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)) != FALSE;
+        const DWORD truncateError = truncated ? ERROR_SUCCESS : GetLastError();
+        CloseLeasedFile(state);
+
+        if (!truncated)
+        {
+            LOG_HR_MSG(
+                HRESULT_FROM_WIN32(truncateError),
+                "Closed a temp file whose lease expired, but couldn't free its space%s. It was created at %s(%u) in %s",
+                truncateError == ERROR_USER_MAPPED_FILE ? " while it is mapped" : "",
+                state.createdAt.file_name(),
+                state.createdAt.line(),
+                state.createdAt.function_name());
+            return;
+        }
+
+        LOG_HR_MSG(
+            HRESULT_FROM_WIN32(ERROR_TIMEOUT),
+            "Reclaimed a temp file whose lease expired. It was created at %s(%u) in %s",
+            state.createdAt.file_name(),
+            state.createdAt.line(),
+            state.createdAt.function_name());
+    }
+}
+
+TmpFileLease::TmpFileLease(std::shared_ptr<details::TmpFileLeaseState> state)
+    : m_state(std::move(state))
+{
+}
+
+TmpFileLease::~TmpFileLease()
+{
+    if (m_state)
+    {
+        auto lock = m_state->lock.try_lock_exclusive();
+        if (!lock)
+        {
+            // The file is in use. Have the reaper close it on its next pass.
+            m_state->released = true;
+            m_state->expiresAtMs = 0;
+            return;
+        }
+
+        if (m_state->file != nullptr)
+        {
+            CloseLeasedFile(*m_state);
+        }
+    }
+}
+
+LeasedTmpFile TmpFileLease::Use()
+{
+    auto lock = m_state->lock.lock_shared();
+    m_state->expiresAtMs = GetTickCount64() + m_state->ttlMs;
+    return LeasedTmpFile{ .file = m_state->file, .lock = std::move(lock) };
+}
+
+bool TmpFileLease::Renew()
+{
+    return Use().file != nullptr;
+}
+
+TmpFileLeases::TmpFileLeases(std::chrono::milliseconds reapInterval)
+{
+    m_reapTimer.reset(CreateThreadpoolTimer(&TmpFileLeases::OnReapTimer, this, nullptr));
+    THROW_LAST_ERROR_IF_NULL(m_reapTimer.get());
+
+    // A negative due time is relative to now, in 100ns units.
+    ULARGE_INTEGER dueTime;
+    dueTime.QuadPart = static_cast<ULONGLONG>(-reapInterval.count() * 10'000);
+    FILETIME dueFileTime{ .dwLowDateTime = dueTime.LowPart, .dwHighDateTime = dueTime.HighPart };
+    SetThreadpoolTimer(m_reapTimer.get(), &dueFileTime, static_cast<DWORD>(reapInterval.count()), 0);
+}
+
+TmpFileLeases::~TmpFileLeases()
+{
+    // Stop the timer and wait for any reaping in progress before the
+    // leases go away.
+    m_reapTimer.reset();
+}
+
+TmpFileLease TmpFileLeases::Create(std::chrono::milliseconds ttl, bool shouldPosixDelete, std::source_location createdAt)
+{
+    TmpFile tmpFile = CreateTmpFileWithPosixDelete(shouldPosixDelete);
+
+    auto state = std::make_shared<details::TmpFileLeaseState>();
+    state->file = tmpFile.file;
+    state->ttlMs = static_cast<uint64_t>(ttl.count());
+    state->expiresAtMs = GetTickCount64() + state->ttlMs;
+    state->createdAt = createdAt;
+
+    auto lock = m_lock.lock_exclusive();
+    m_leases.push_back(state);
+    return TmpFileLease{ std::move(state) };
+}
+
+void CALLBACK TmpFileLeases::OnReapTimer(PTP_CALLBACK_INSTANCE, void* context, PTP_TIMER) try
+{
+    static_cast<TmpFileLeases*>(context)->Reap();
+}
+CATCH_LOG()
+
+void TmpFileLeases::Reap()
+{
+    const uint64_t now = GetTickCount64();
+
+    // Reclaim files without holding m_lock, so that creating new leases
+    // doesn't wait on reclaiming I/O.
+    std::vector<std::shared_ptr<details::TmpFileLeaseState>> expired;
+    {
+        auto lock = m_lock.lock_shared();
+        for (const std::shared_ptr<details::TmpFileLeaseState>& state : m_leases)
+        {
+            if (state->expiresAtMs <= now)
+            {
+                expired.push_back(state);
+            }
+        }
+    }
+
+    for (const std::shared_ptr<details::TmpFileLeaseState>& state : expired)
+    {
+        // One lease failing shouldn't keep the others from being reclaimed.
+        try
+        {
+            ReclaimIfUnused(*state);
+        }
+        CATCH_LOG()
+    }
+
+    auto lock = m_lock.lock_exclusive();
+
+    // Forget about files that have been closed, whether by the reaper or
+    // by their lease holders.
+    std::erase_if(m_leases, [](const std::shared_ptr<details::TmpFileLeaseState>& state)
+        {
+            auto stateLock = state->lock.try_lock_shared();
+            return stateLock && state->file == nullptr;
+        });
+}
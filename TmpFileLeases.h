@@ -0,0 +1,133 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <source_location>
+#include <stdio.h>
+#include <vector>
+
+// Leases on temp files, so that temp files that are forgotten about, but
+// never closed, get reclaimed without waiting for the process to exit.
+//
+// A POSIX-deleted temp file that is leaked isn't visible anywhere, but its
+// disk space stays in use until its HANDLE is closed. A leased temp file
+// must be used, or its lease renewed, at least every ttl. A background
+// reaper truncates and closes temp files whose leases have expired, and
+// logs where they were created.
+
+class TmpFileLeases;
+
+namespace details
+{
+    struct TmpFileLeaseState
+    {
+        wil::srwlock lock;
+
+        // nullptr once the file has been closed.
+        FILE* file;
+
+        // Set when the lease was dropped while the file was in use, so
+        // the reaper closes the file instead.
+        std::atomic<bool> released{ false };
+
+        uint64_t ttlMs;
+        std::atomic<uint64_t> expiresAtMs;
+        std::source_location createdAt;
+    };
+}
+
+// A temp file that is in use. The reaper won't close the file while this
+// exists.
+struct LeasedTmpFile
+{
+    // nullptr if the file was reclaimed because its lease expired.
+    FILE* file;
+
+    wil::rwlock_release_shared_scope_exit lock;
+};
+
+class TmpFileLease
+{
+public:
+    TmpFileLease(TmpFileLease&&) = default;
+    TmpFileLease& operator=(TmpFileLease&&) = delete;
+
+    // Closes the file, if it hasn't been reclaimed. If a LeasedTmpFile from
+    // Use is still alive, the file is left for the reaper to close once it
+    // is gone, instead of waiting for it here, which would deadlock if it
+    // is on this thread.
+    ~TmpFileLease();
+
+    // Renews the lease and gets the file. Hold on to the result for as long
+    // as the file is being used.
+    LeasedTmpFile Use();
+
+    // Renews the lease. Returns false if the file was already reclaimed.
+    bool Renew();
+
+private:
+    friend class TmpFileLeases;
+
+    explicit TmpFileLease(std::shared_ptr<details::TmpFileLeaseState> state);
+
+    std::shared_ptr<details::TmpFileLeaseState> m_state;
+};
+
+class TmpFileLeases
+{
+public:
+    // Starts the reaper, which checks for expired leases every
+    // reapInterval.
+    explicit TmpFileLeases(std::chrono::milliseconds reapInterval = std::chrono::seconds{ 1 });
+
+    // Stops the reaper. Files whose leases are still held stay open, as do
+    // files whose leases were dropped while they were in use.
+    ~TmpFileLeases();
+
+    TmpFileLeases(const TmpFileLeases&) = delete;
+    TmpFileLeases& operator=(const TmpFileLeases&) = delete;
+
+    // Creates a temp file like CreateTmpFileWithPosixDelete does, with a
+    // lease of ttl.
+    TmpFileLease Create(
+        std::chrono::milliseconds ttl,
+        bool shouldPosixDelete = true,
+        std::source_location createdAt = std::source_location::current());
+
+private:
+    static void CALLBACK OnReapTimer(PTP_CALLBACK_INSTANCE, void* context, PTP_TIMER);
+
+    void Reap();
+
+    wil::srwlock m_lock;
+    std::vector<std::shared_ptr<details::TmpFileLeaseState>> m_leases;
+    wil::unique_threadpool_timer m_reapTimer;
+};
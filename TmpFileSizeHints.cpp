@@ -0,0 +1,165 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TmpFileSizeHints.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+void TmpFileSizeHints::Record(std::wstring_view tag, uint64_t finalSize)
+{
+    auto lock = m_lock.lock_exclusive();
+
+    auto it = m_sketches.find(tag);
+    if (it == m_sketches.end())
+    {
+        it = m_sketches.emplace(std::wstring{ tag }, Sketch{}).first;
+    }
+
+    it->second.Add(finalSize);
+}
+
+TmpFileSizeHint TmpFileSizeHints::GetHint(std::wstring_view tag) const
+{
+    auto lock = m_lock.lock_shared();
+
+    auto it = m_sketches.find(tag);
+    if (it == m_sketches.end() || it->second.Count() < c_minSamples)
+    {
+        return TmpFileSizeHint{ .preallocateBytes = 0, .preferInMemory = false };
+    }
+
+    // Preallocate enough for most files. The rest grow as usual.
+    return TmpFileSizeHint{
+        .preallocateBytes = it->second.Quantile(0.9),
+        .preferInMemory = it->second.Quantile(0.99) <= c_inMemoryThreshold,
+    };
+}
+
+uint64_t TmpFileSizeHints::GetQuantile(std::wstring_view tag, double q) const
+{
+    auto lock = m_lock.lock_shared();
+
+    auto it = m_sketches.find(tag);
+    return it == m_sketches.end() ? 0 : it->second.Quantile(q);
+}
+
+void TmpFileSizeHints::Sketch::Add(uint64_t value)
+{
+    if (m_count == c_maxCount)
+    {
+        // Decay older samples. Rounding up keeps every non-empty bucket
+        // non-empty.
+        m_count = 0;
+        for (uint32_t& bucket : m_buckets)
+        {
+            bucket = (bucket + 1) / 2;
+            m_count += bucket;
+        }
+    }
+
+    ++m_buckets[BucketIndex(value)];
+    ++m_count;
+}
+
+uint64_t TmpFileSizeHints::Sketch::Quantile(double q) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * m_count)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_buckets.size(); ++i)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            return BucketUpperBound(i);
+        }
+    }
+
+    return BucketUpperBound(m_buckets.size() - 1);
+}
+
+size_t TmpFileSizeHints::Sketch::BucketIndex(uint64_t value)
+{
+    // Values below c_subBuckets get a bucket each. Above that, each power
+    // of two is split into c_subBuckets equal parts.
+    if (value < c_subBuckets)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    const int msb = std::bit_width(value) - 1;
+    const uint64_t sub = (value >> (msb - 2)) & (c_subBuckets - 1);
+    return static_cast<size_t>((msb - 1) * c_subBuckets + sub);
+}
+
+uint64_t TmpFileSizeHints::Sketch::BucketUpperBound(size_t index)
+{
+    if (index < c_subBuckets)
+    {
+        return index;
+    }
+
+    const int msb = static_cast<int>(index / c_subBuckets) + 1;
+    const uint64_t sub = index % c_subBuckets;
+    if (msb == 63 && sub == c_subBuckets - 1)
+    {
+        return UINT64_MAX;
+    }
+
+    return ((c_subBuckets + sub + 1) << (msb - 2)) - 1;
+}
+
+TmpFile CreateTmpFileWithSizeHint(const TmpFileSizeHints& hints, std::wstring_view tag, bool shouldPosixDelete)
+{
+    TmpFile tmpFile = CreateTmpFileWithPosixDelete(shouldPosixDelete);
+
+    const TmpFileSizeHint hint = hints.GetHint(tag);
+    if (hint.preallocateBytes != 0)
+    {
+        // Reserve the space up front so that the file system can allocate
+        // it contiguously, instead of extending the file a bit at a time.
+        // The file's size stays 0.
+        FILE_ALLOCATION_INFO allocation{};
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(hint.preallocateBytes);
+        LOG_IF_WIN32_BOOL_FALSE(SetFileInformationByHandle(tmpFile.handle, FileAllocationInfo, &allocation, sizeof(allocation)));
+    }
+
+    return tmpFile;
+}
+
+void RecordTmpFileSize(TmpFileSizeHints& hints, std::wstring_view tag, const TmpFile& tmpFile)
+{
+    THROW_HR_IF(ErrnoToHresult(errno), fflush(tmpFile.file) != 0);
+
+    LARGE_INTEGER size;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(tmpFile.handle, &size));
+    hints.Record(tag, static_cast<uint64_t>(size.QuadPart));
+}
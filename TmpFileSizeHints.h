@@ -0,0 +1,102 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "TmpFile.h"
+
+#include <wil/resource.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Size hints for temp files, learned from the final sizes of earlier temp
+// files created for the same purpose.
+//
+// Callers pick a tag that describes what a temp file is for (e.g., the
+// operator that is spilling), record each file's final size under that
+// tag, and later creations with the same tag get preallocated to a size
+// that most earlier files fit in.
+
+struct TmpFileSizeHint
+{
+    // Bytes to preallocate, or 0 if there isn't enough history for the tag.
+    uint64_t preallocateBytes;
+
+    // Whether nearly all earlier files with the tag were small enough that
+    // the caller should keep the data in memory instead of in a temp file.
+    bool preferInMemory;
+};
+
+class TmpFileSizeHints
+{
+public:
+    // Files whose size is at or below this are considered small enough to
+    // keep in memory.
+    static constexpr uint64_t c_inMemoryThreshold = 64 * 1024;
+
+    // No hints are given for a tag until this many sizes have been recorded.
+    static constexpr uint32_t c_minSamples = 8;
+
+    void Record(std::wstring_view tag, uint64_t finalSize);
+
+    TmpFileSizeHint GetHint(std::wstring_view tag) const;
+
+    // Gets an estimate of the q quantile of the sizes recorded for tag, or
+    // 0 if nothing has been recorded. The estimate is rounded up, and is
+    // within about 25% of the true value.
+    uint64_t GetQuantile(std::wstring_view tag, double q) const;
+
+private:
+    // A log-linear histogram: four buckets per power of two. Counts are
+    // halved once there are enough of them so that the sketch follows
+    // changes in behavior instead of averaging over all of history.
+    class Sketch
+    {
+    public:
+        void Add(uint64_t value);
+        uint64_t Quantile(double q) const;
+        uint32_t Count() const { return m_count; }
+
+    private:
+        static constexpr uint32_t c_subBuckets = 4;
+        static constexpr uint32_t c_maxCount = 1024;
+
+        static size_t BucketIndex(uint64_t value);
+        static uint64_t BucketUpperBound(size_t index);
+
+        std::array<uint32_t, 64 * c_subBuckets> m_buckets{};
+        uint32_t m_count = 0;
+    };
+
+    mutable wil::srwlock m_lock;
+    std::map<std::wstring, Sketch, std::less<>> m_sketches;
+};
+
+// Creates a temp file like CreateTmpFileWithPosixDelete does, and
+// preallocates it according to the hints for tag.
+TmpFile CreateTmpFileWithSizeHint(const TmpFileSizeHints& hints, std::wstring_view tag, bool shouldPosixDelete);
+
+// Records the current size of tmpFile under tag. Call this right before
+// closing the file.
+void RecordTmpFileSize(TmpFileSizeHints& hints, std::wstring_view tag, const TmpFile& tmpFile);
@@ -0,0 +1,247 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TmpFileWindow.h"
+
+#include "SparseFile.h"
+#include "TmpFile.h"
+
+#include <windows.h>
+
+#include <wil/result.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    uint64_t RoundUp(uint64_t value, uint64_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // Each thread waits for one read at a time, so it can reuse one event
+    // for all of them.
+    HANDLE GetReadEvent()
+    {
+        thread_local wil::unique_event readEvent{ wil::EventOptions::ManualReset };
+        return readEvent.get();
+    }
+}
+
+TmpFileWindow::Cursor::Cursor(const TmpFileWindow& window, uint64_t position)
+    : m_window(window)
+    , m_position(std::min(position, window.Head()))
+{
+}
+
+size_t TmpFileWindow::Cursor::Read(std::span<std::byte> buffer)
+{
+    for (;;)
+    {
+        const uint64_t tail = m_window.Tail();
+        if (m_position < tail)
+        {
+            m_lostBytes += tail - m_position;
+            m_position = tail;
+        }
+
+        const uint64_t head = m_window.Head();
+        if (m_position >= head)
+        {
+            return 0;
+        }
+
+        const size_t toRead = static_cast<size_t>(std::min<uint64_t>(buffer.size(), head - m_position));
+        if (toRead == 0)
+        {
+            return 0;
+        }
+
+        // If the producer overwrote part of this while we read it, skip
+        // ahead to the new tail and try again.
+        if (m_window.TryReadAt(m_position, buffer.first(toRead)))
+        {
+            m_position += toRead;
+            return toRead;
+        }
+    }
+}
+
+TmpFileWindow::TmpFileWindow(uint64_t capacity)
+    : m_file(CreateTmpFileWithPosixDelete(true).file)
+    , m_handle(GetTmpFileHandle(m_file.get()))
+    , m_capacity(std::max(RoundUp(capacity, c_viewSize), 2 * c_viewSize))
+{
+    MakeSparse(m_handle);
+
+    m_readFile.reset(ReOpenFile(
+        m_handle,
+        GENERIC_READ,
+        FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE,
+        FILE_FLAG_OVERLAPPED));
+    THROW_LAST_ERROR_IF(!m_readFile.is_valid());
+
+    // The mapping extends the file to the full capacity. Since the file is
+    // sparse, that doesn't allocate anything.
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(m_capacity);
+    m_mapping.reset(CreateFileMappingW(m_handle, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr));
+    THROW_LAST_ERROR_IF(!m_mapping.is_valid());
+
+    MapViewAt(0, 0);
+}
+
+void TmpFileWindow::Append(std::span<const std::byte> data)
+{
+    THROW_HR_IF(E_INVALIDARG, data.size() > m_capacity);
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t newHead = head + data.size();
+
+    if (newHead - m_tail.load(std::memory_order_relaxed) > m_capacity)
+    {
+        // Drop the oldest chunks to make room. Readers must see the new
+        // tail before any of the data that overwrites the old one, so that
+        // they can tell their reads were overwritten.
+        m_tail.store(std::min(RoundUp(newHead - m_capacity, c_chunkSize), newHead), std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_punchedTo = std::max(m_punchedTo, m_tail.load(std::memory_order_relaxed));
+    }
+
+    while (!data.empty())
+    {
+        const uint64_t physical = head % m_capacity;
+        if (physical < m_viewOffset || physical >= m_viewOffset + c_viewSize)
+        {
+            const uint64_t viewOffset = physical / c_viewSize * c_viewSize;
+            MapViewAt(viewOffset, head - (physical - viewOffset));
+        }
+
+        const size_t toCopy = static_cast<size_t>(std::min<uint64_t>(data.size(), m_viewOffset + c_viewSize - physical));
+        std::memcpy(m_view.get() + (physical - m_viewOffset), data.data(), toCopy);
+
+        head += toCopy;
+        data = data.subspan(toCopy);
+    }
+
+    m_head.store(newHead, std::memory_order_release);
+}
+
+void TmpFileWindow::DiscardBefore(uint64_t offset)
+{
+    offset = std::min(offset, m_head.load(std::memory_order_relaxed));
+    if (offset <= m_tail.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    m_tail.store(offset, std::memory_order_seq_cst);
+    PunchDiscardedChunks();
+}
+
+bool TmpFileWindow::TryReadAt(uint64_t offset, std::span<std::byte> buffer) const
+{
+    if (offset < Tail() || offset + buffer.size() > Head())
+    {
+        return false;
+    }
+
+    const uint64_t start = offset;
+
+    // Reads go through the file rather than the producer's view, which may
+    // be remapped at any time. Both see the same cached pages.
+    const HANDLE readEvent = GetReadEvent();
+    while (!buffer.empty())
+    {
+        const uint64_t physical = offset % m_capacity;
+        const DWORD toRead = static_cast<DWORD>(std::min<uint64_t>({ buffer.size(), m_capacity - physical, MAXDWORD }));
+
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(physical);
+        overlapped.OffsetHigh = static_cast<DWORD>(physical >> 32);
+        overlapped.hEvent = readEvent;
+
+        if (!ReadFile(m_readFile.get(), buffer.data(), toRead, nullptr, &overlapped))
+        {
+            THROW_LAST_ERROR_IF(GetLastError() != ERROR_IO_PENDING);
+        }
+
+        DWORD bytesRead = 0;
+        THROW_IF_WIN32_BOOL_FALSE(GetOverlappedResult(m_readFile.get(), &overlapped, &bytesRead, TRUE));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), bytesRead == 0);
+
+        offset += bytesRead;
+        buffer = buffer.subspan(bytesRead);
+    }
+
+    // If the tail moved past where we started while we were reading, the
+    // producer may have overwritten some of what we read.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return Tail() <= start;
+}
+
+void TmpFileWindow::MapViewAt(uint64_t physicalOffset, uint64_t logicalOffset)
+{
+    // Keep the old view until the new one is mapped, so that a failure
+    // leaves the producer with a view that matches m_viewOffset.
+    wil::unique_mapview_ptr<std::byte> view{ static_cast<std::byte*>(MapViewOfFile(
+        m_mapping.get(),
+        FILE_MAP_WRITE,
+        static_cast<DWORD>(physicalOffset >> 32),
+        static_cast<DWORD>(physicalOffset),
+        c_viewSize)) };
+    THROW_LAST_ERROR_IF_NULL(view.get());
+
+    m_view = std::move(view);
+    m_viewOffset = physicalOffset;
+    m_viewLogicalOffset = logicalOffset;
+
+    // Chunks that were waiting on the old view can be punched out now.
+    PunchDiscardedChunks();
+}
+
+void TmpFileWindow::PunchDiscardedChunks()
+{
+    // Punch out whole chunks behind the tail. Leave discarded chunks from
+    // the current view until the producer moves past it, since mapped
+    // ranges can't be punched out.
+    const uint64_t end = std::min(m_tail.load(std::memory_order_relaxed) / c_chunkSize * c_chunkSize, m_viewLogicalOffset);
+    while (m_punchedTo < end)
+    {
+        const uint64_t physical = m_punchedTo % m_capacity;
+        const uint64_t length = std::min(end - m_punchedTo, c_viewSize - physical % c_viewSize);
+
+        // Chunks from the previous lap around the file that are in the
+        // current view are about to be overwritten anyway.
+        if (physical / c_viewSize * c_viewSize != m_viewOffset)
+        {
+            // This only saves disk space, so failing to do it isn't fatal.
+            try
+            {
+                PunchHole(m_handle, physical, length);
+            }
+            CATCH_LOG()
+        }
+
+        m_punchedTo += length;
+    }
+}
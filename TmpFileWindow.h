@@ -0,0 +1,134 @@
+// Copyright (c) 2026 Microsoft
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <windows.h>
+
+// Must come before wil/resource.h for wil::unique_file.
+#include <stdio.h>
+
+#include <wil/resource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// A fixed-capacity window over the most recent bytes of a stream, stored
+// in one POSIX-deleted, sparse temp file used as a ring buffer.
+//
+// Bytes are addressed by their logical offset in the stream. The window
+// holds [Tail(), Head()). One producer thread appends at the head, which
+// overwrites the oldest bytes once the window is full, and can discard
+// bytes at the tail early. Discarded ranges are punched out of the file,
+// so its disk usage stays at about Head() - Tail().
+//
+// The producer writes through a mapped view of the region around the
+// head. Only that region is mapped, since holes can't be punched in mapped
+// ranges. Any number of threads can read with Cursors, without locking:
+// a read that raced with the producer overwriting what it read is detected
+// and reported as lost data.
+//
+// The temp file's own HANDLE is synchronous, and the I/O manager
+// serializes synchronous I/O on a file object. Readers go through a
+// second, overlapped file object from ReOpenFile instead, so their reads
+// run concurrently.
+class TmpFileWindow
+{
+public:
+    // The size of the producer's mapped view of the file.
+    static constexpr uint64_t c_viewSize = 16 * 1024 * 1024;
+
+    // Holes are punched in units of this size.
+    static constexpr uint64_t c_chunkSize = 64 * 1024;
+
+    // Reads the window from a position onwards.
+    class Cursor
+    {
+    public:
+        // A position past the head is moved back to the head.
+        Cursor(const TmpFileWindow& window, uint64_t position);
+
+        uint64_t Position() const { return m_position; }
+
+        // Total bytes that were skipped because the window's tail passed
+        // the cursor before they were read.
+        uint64_t LostBytes() const { return m_lostBytes; }
+
+        // Reads up to buffer.size() bytes at the cursor and advances past
+        // them. Returns 0 if nothing has been appended past the cursor yet.
+        size_t Read(std::span<std::byte> buffer);
+
+    private:
+        const TmpFileWindow& m_window;
+        uint64_t m_position;
+        uint64_t m_lostBytes = 0;
+    };
+
+    // capacity is rounded up to a multiple of c_viewSize, and is at least
+    // two views.
+    explicit TmpFileWindow(uint64_t capacity);
+
+    TmpFileWindow(const TmpFileWindow&) = delete;
+    TmpFileWindow& operator=(const TmpFileWindow&) = delete;
+
+    uint64_t Capacity() const { return m_capacity; }
+    uint64_t Head() const { return m_head.load(std::memory_order_acquire); }
+    uint64_t Tail() const { return m_tail.load(std::memory_order_acquire); }
+
+    // Appends bytes at the head, dropping the oldest bytes if there isn't
+    // room. Only call this from the producer thread.
+    void Append(std::span<const std::byte> data);
+
+    // Discards everything before offset, and punches it out of the file.
+    // Only call this from the producer thread.
+    void DiscardBefore(uint64_t offset);
+
+    // Copies [offset, offset + buffer.size()) into buffer. Returns false,
+    // with buffer's contents undefined, if any of that range is not in
+    // the window, or left it during the read.
+    bool TryReadAt(uint64_t offset, std::span<std::byte> buffer) const;
+
+private:
+    void MapViewAt(uint64_t physicalOffset, uint64_t logicalOffset);
+    void PunchDiscardedChunks();
+
+    wil::unique_file m_file;
+    HANDLE m_handle;
+    uint64_t m_capacity;
+
+    // An overlapped file object for readers.
+    wil::unique_hfile m_readFile;
+
+    wil::unique_handle m_mapping;
+    wil::unique_mapview_ptr<std::byte> m_view;
+    uint64_t m_viewOffset = 0;
+
+    // The logical offset of the start of the producer's current view.
+    uint64_t m_viewLogicalOffset = 0;
+
+    // Chunks before this logical offset have been punched out, or were
+    // overwritten by newer data.
+    uint64_t m_punchedTo = 0;
+
+    std::atomic<uint64_t> m_head{ 0 };
+    std::atomic<uint64_t> m_tail{ 0 };
+};